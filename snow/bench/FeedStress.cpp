@@ -0,0 +1,183 @@
+// 共享内存雪花数据 (SnowFeed) 的并发压力测试：一个线程不停地发布，
+// 几个线程用各自独立的映射不停地读，检查读到的每一帧都是完整的 (没有撕裂)
+// 不依赖 Windows，Linux 上这样编译：
+//   g++ -O2 -std=c++17 -pthread -I../src -o feed_stress
+//       FeedStress.cpp ../src/SnowFeed.cpp
+//   (写在一行里，有的系统还要加 -lrt)
+// 用法：feed_stress [秒数] [读线程数]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "SnowFeed.h"
+
+static const char FEED_NAME[]  = "/snow-feed-stress";
+static const char STALE_NAME[] = "/snow-feed-stale";
+
+// 第 frame 帧有几颗：在 1 到 capacity 之间来回变，块里的旧数据长短不一
+static uint32_t CountOf(uint64_t frame, uint32_t capacity)
+{
+    return 1 + (uint32_t)((frame * 7919) % capacity);
+}
+
+// 上一个写端崩在写到一半的地方，新的写端又打开了同一块内存
+// (POSIX 上是没 shm_unlink 留下来的，Windows 上是还有读端开着映射)
+// 这里用另一个映射一直开着它，里面填满垃圾，所有块的 seq 都是奇数，
+// 再看新写端发的每一帧都能完整地读出来
+static bool StaleSegment(uint32_t capacity, uint32_t slots)
+{
+    // 和 SnowFeedWriter::Open 算的大小一样
+    size_t stride = sizeof(SnowFeedSlotHeader) +
+                    (size_t)capacity * sizeof(SnowFeedParticle);
+    stride        = (stride + 63) & ~(size_t)63;
+    size_t size   = sizeof(SnowFeedHeader) + stride * slots;
+
+    SharedMemory stale;
+    if (!stale.Create(STALE_NAME, size))
+    {
+        printf("cannot create shared memory %s\n", STALE_NAME);
+        return false;
+    }
+    memset(stale.Data(), 0xA5, size);
+
+    SnowFeedWriter writer;
+    SnowFeedReader reader;
+    if (!writer.Open(STALE_NAME, capacity, slots) || !reader.Open(STALE_NAME))
+    {
+        printf("cannot reopen stale shared memory %s\n", STALE_NAME);
+        return false;
+    }
+
+    // 每块都要轮到好几次
+    SnowSnapshot                  snapshot;
+    SnowFeedSlotHeader            info;
+    std::vector<SnowFeedParticle> particles;
+    int                           failed = 0;
+    for (uint64_t frame = 1; frame <= slots * 4; ++frame)
+    {
+        uint32_t n = CountOf(frame, capacity);
+        snapshot.sprites.assign(n, {(float)frame, 0.0f, 1.0f, 1.0f});
+        snapshot.tick = (uint32_t)frame;
+        writer.Publish(snapshot);
+
+        bool ok = reader.Read(info, particles) && info.frame == frame &&
+                  info.count == n && particles[n - 1].x == (float)frame;
+        if (!ok)
+            ++failed;
+    }
+
+    printf("stale segment: %d of %u frames unreadable\n", failed, slots * 4);
+    return failed == 0;
+}
+
+struct ReaderStats
+{
+    uint64_t reads    = 0;  // 读到的完整帧
+    uint64_t misses   = 0;  // 重试几次都没读到 (写得太快)
+    uint64_t rejected = 0;  // 读的时候看到了撕裂，被 seq 检查拦下来的
+    uint64_t torn     = 0;  // 撕裂的数据被当成完整的交出来了 (必须是 0)
+};
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int    readers = argc > 2 ? atoi(argv[2]) : 3;
+
+    // 块少、每块小：写端很快绕回来覆盖正在读的块，撞车的机会多
+    const uint32_t capacity = 4096;
+    const uint32_t slots    = 2;
+
+    bool staleOk = StaleSegment(capacity, 4);
+
+    SnowFeedWriter writer;
+    if (!writer.Open(FEED_NAME, capacity, slots))
+    {
+        printf("cannot create shared memory %s\n", FEED_NAME);
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+
+    // 发布端：第 frame 帧的每颗粒子都带着帧号，读端据此检查是不是同一帧的
+    std::thread publisher([&] {
+        SnowSnapshot snapshot;
+        uint64_t     frame = 0;
+        while (running.load(std::memory_order_relaxed))
+        {
+            ++frame;
+            uint32_t n = CountOf(frame, capacity);
+            snapshot.sprites.resize(n / 2);
+            snapshot.landed.resize(n - n / 2);
+            for (size_t i = 0; i < snapshot.sprites.size(); ++i)
+                snapshot.sprites[i] = {(float)frame, (float)i, 1.0f, 1.0f};
+            for (size_t i = 0; i < snapshot.landed.size(); ++i)
+                snapshot.landed[i] = {{(float)frame, (float)i, 1.0f, 1.0f}, 0};
+            snapshot.tick = (uint32_t)frame;
+            writer.Publish(snapshot);
+        }
+    });
+
+    std::vector<ReaderStats> stats(readers);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&, r] {
+            // 每个读线程自己映射一次 (不同的地址，同一块物理内存)
+            SnowFeedReader reader;
+            while (!reader.Open(FEED_NAME))
+                std::this_thread::yield();
+
+            ReaderStats &s = stats[r];
+            while (running.load(std::memory_order_relaxed))
+            {
+                bool consistent = true;
+                bool ok         = reader.Peek(
+                    [&](const SnowFeedSlotHeader &slot,
+                        const SnowFeedParticle   *particles,
+                        uint32_t                  count) {
+                        uint64_t frame = slot.frame;
+                        consistent     = count == CountOf(frame, capacity) &&
+                                     slot.tick == (uint32_t)frame;
+                        for (uint32_t i = 0; i < count && consistent; ++i)
+                            consistent = particles[i].x == (float)frame;
+                        if (!consistent)
+                            ++s.rejected;
+                    });
+
+                if (!ok)
+                    ++s.misses;
+                else if (!consistent)
+                    ++s.torn;  // 最后一次 visit 不一致，Peek 却说读完整了
+                else
+                    ++s.reads;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    publisher.join();
+    for (auto &t : threads)
+        t.join();
+
+    ReaderStats total;
+    for (const auto &s : stats)
+    {
+        total.reads += s.reads;
+        total.misses += s.misses;
+        total.torn += s.torn;
+        total.rejected += s.rejected - (s.torn > 0 ? s.torn : 0);
+    }
+
+    printf("readers %d, %.1f s\n", readers, seconds);
+    printf("  complete reads     %llu\n", (unsigned long long)total.reads);
+    printf("  gave up (retries)  %llu\n", (unsigned long long)total.misses);
+    printf("  torn, rejected     %llu\n", (unsigned long long)total.rejected);
+    printf("  torn, accepted     %llu\n", (unsigned long long)total.torn);
+
+    writer.Close();
+    return total.torn == 0 && staleOk ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+// 障碍物查找的基准测试：在合成的桌面上跑 ObstacleFinder
+// 不依赖 Windows，Linux 上这样编译：
+//   g++ -O2 -std=c++17 -I../src -o obstacle_bench
+//       ObstacleBench.cpp SyntheticDesktop.cpp ../src/ObstacleFinder.cpp
+//   (写在一行里)
+// 用法：obstacle_bench [种子]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include "ObstacleFinder.h"
+#include "SyntheticDesktop.h"
+
+// 反复跑到至少 0.2 秒，返回平均每次多少微秒
+template <typename Fn>
+static double TimeIt(Fn &&discover)
+{
+    using Clock  = std::chrono::steady_clock;
+    auto   start = Clock::now();
+    double elapsed;
+    int    runs = 0;
+    do
+    {
+        discover();
+        ++runs;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < 0.2);
+
+    return elapsed * 1e6 / runs;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 10) : 1;
+
+    const int counts[] = {10, 30, 100, 300, 1000};
+
+    // 前一半是不带缓存的，后一半是带缓存、桌面没变时 (稳定状态)
+    printf("%-12s %7s %9s %10s %8s %6s %9s %8s %6s %9s\n",
+           "layout",
+           "windows",
+           "obstacles",
+           "accumulate",
+           "queries",
+           "dwm",
+           "us",
+           "cached",
+           "dwm",
+           "us");
+
+    for (int l = 0; l < SyntheticDesktop::LAYOUT_COUNT; ++l)
+    {
+        auto layout = (SyntheticDesktop::Layout)l;
+        for (int count : counts)
+        {
+            SyntheticDesktop desktop;
+            desktop.Generate(layout, count, 1920, 1080, seed);
+
+            // 先跑一次拿结果，顺便数一下查询次数
+            desktop.ResetQueries();
+            std::vector<Obstacle> obstacles = ObstacleFinder::Find(desktop);
+            size_t                queries   = desktop.Queries();
+            size_t                frames    = desktop.FrameQueries();
+
+            size_t accumulate = 0;
+            for (const auto &obs : obstacles)
+                accumulate += obs.canAccumulate;
+
+            double us = TimeIt([&] { obstacles = ObstacleFinder::Find(desktop); });
+
+            // 带缓存：第一次把缓存填满，之后数稳定状态下的查询
+            ObstacleFinder finder;
+            finder.FindCached(desktop);
+            desktop.ResetQueries();
+            std::vector<Obstacle> cached = finder.FindCached(desktop);
+            size_t cachedQueries = desktop.Queries();
+            size_t cachedFrames  = desktop.FrameQueries();
+
+            if (cached.size() != obstacles.size())
+                printf("!! cached result differs\n");
+
+            double cachedUs =
+                TimeIt([&] { cached = finder.FindCached(desktop); });
+
+            printf("%-12s %7d %9zu %10zu %8zu %6zu %9.2f %8zu %6zu %9.2f\n",
+                   SyntheticDesktop::LayoutName(layout),
+                   count,
+                   obstacles.size(),
+                   accumulate,
+                   queries,
+                   frames,
+                   us,
+                   cachedQueries,
+                   cachedFrames,
+                   cachedUs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,360 @@
+// 帧节奏 (FramePacer) 和固定步长模拟 (FixedStep) 的模拟时钟测试：
+// 时钟是假的，“等”只是把时间往前拨，可以随意造出醒晚了、醒早了、
+// 卡了几秒、中途改帧率这些情况，几十万帧一眨眼就跑完，结果每次都一样
+// 检查：
+//   - 节拍不漂移 (醒晚了不把后面的帧往后推)
+//   - 错过的截止时间一帧不多一帧不少
+//   - 改帧率以后从改的那一刻按新间隔重新排
+//   - 卡顿以后模拟最多补 MAX_STEPS 步，欠的丢掉，节拍的相位不变
+// 不依赖 Windows，Linux 上这样编译：
+//   g++ -O2 -std=c++17 -I../src -o pacer_sim PacerSim.cpp ../src/FramePacer.cpp
+//   (写在一行里)
+// 用法：pacer_sim [种子]
+// 全部通过返回 0，否则打印哪一项不对并返回 1
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <random>
+#include "FramePacer.h"
+
+// 和 Main.cpp 一样的模拟步长
+static const int64_t SIM_STEP_US = 33333;
+static const int     MAX_STEPS   = 3;
+
+// 假时钟：WaitUntil 直接把时间拨到截止时间，再按设定早醒或者晚醒一点
+class SimClock : public FrameClock
+{
+  public:
+    explicit SimClock(uint32_t seed) : m_rng(seed) {}
+
+    int64_t Now() override { return m_now; }
+
+    void WaitUntil(int64_t deadline) override
+    {
+        int64_t wake = deadline - m_early;
+        if (m_jitter > 0)
+            wake += std::uniform_int_distribution<int64_t>(0, m_jitter)(m_rng);
+        if (m_stall > 0)
+        {
+            wake += m_stall;
+            m_stall = 0;
+        }
+        m_lastDeadline = deadline;
+        m_now          = wake > m_now ? wake : m_now;
+    }
+
+    // 每次最多晚醒多少、固定早醒多少、下一次额外卡多久 (微秒)
+    void SetJitter(int64_t jitter) { m_jitter = jitter; }
+    void SetEarly(int64_t early) { m_early = early; }
+    void Stall(int64_t stall) { m_stall = stall; }
+
+    // 不等，时间直接过去 (两帧之间干别的去了)
+    void Skip(int64_t us) { m_now += us; }
+
+    // 最近一次等的截止时间 (算预期的错过次数用)
+    int64_t LastDeadline() const { return m_lastDeadline; }
+
+  private:
+    std::mt19937 m_rng;
+    int64_t      m_now          = 1000000;  // 不从 0 开始：0 是“还没排过”
+    int64_t      m_jitter       = 0;
+    int64_t      m_early        = 0;
+    int64_t      m_stall        = 0;
+    int64_t      m_lastDeadline = 0;
+};
+
+static int s_failures = 0;
+
+static void Expect(bool ok, const char *fmt, ...)
+{
+    if (ok)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    printf("    FAILED: ");
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+    ++s_failures;
+}
+
+// 跑 frames 帧，检查模拟步长的守恒：跑了的 + 丢了的步数正好把时间填到
+// 不到一步的零头 (不多跑、不漏跑)，而且每帧最多补 MAX_STEPS 步
+struct StepCheck
+{
+    FixedStep step{SIM_STEP_US, MAX_STEPS};
+    int64_t   first = 0;
+    int       most  = 0;  // 一帧里最多跑了几步
+    bool      ok    = true;
+
+    int Frame(int64_t now)
+    {
+        if (first == 0)
+            first = now;
+
+        int n = step.Advance(now);
+        most  = n > most ? n : most;
+
+        // 第一帧马上跑一步，所以模拟时间从 first - 一步 算起
+        int64_t simTime = first - SIM_STEP_US +
+                          (int64_t)(step.Steps() + step.DroppedSteps()) *
+                              SIM_STEP_US;
+        float ahead = step.Ahead(now);
+        if (n > MAX_STEPS || now - simTime < 0 ||
+            now - simTime >= SIM_STEP_US || ahead < 0.0f || ahead >= 1.0f)
+            ok = false;
+        return n;
+    }
+};
+
+// 准点醒：每帧正好隔一个周期，一帧不错过
+static void Steady(uint32_t seed)
+{
+    printf("  steady 60 fps\n");
+    SimClock   clock(seed);
+    FramePacer pacer(clock);
+    pacer.SetTargetFps(60.0);
+
+    int64_t t0    = pacer.WaitNextFrame();
+    bool    exact = true;
+    for (int k = 1; k <= 6000; ++k)
+        exact = exact && pacer.WaitNextFrame() == t0 + k * pacer.Period();
+
+    Expect(exact, "frame starts drift from t0 + k * period");
+    Expect(pacer.MissedDeadlines() == 0,
+           "missed %llu deadlines",
+           (unsigned long long)pacer.MissedDeadlines());
+    Expect(pacer.Period() == 16667,
+           "period %lld",
+           (long long)pacer.Period());
+}
+
+// 每次都晚醒一点 (不到一个周期)：不错过，节拍也不往后漂
+static void Jitter(uint32_t seed)
+{
+    printf("  jitter below one period\n");
+    SimClock   clock(seed);
+    FramePacer pacer(clock);
+    pacer.SetTargetFps(144.0);
+    clock.SetJitter(pacer.Period() * 9 / 10);
+
+    const int frames = 100000;
+    int64_t   t0     = pacer.WaitNextFrame();
+    int64_t   worst  = 0;
+    for (int k = 1; k <= frames; ++k)
+    {
+        pacer.WaitNextFrame();
+        worst = pacer.LastLateness() > worst ? pacer.LastLateness() : worst;
+    }
+
+    Expect(pacer.MissedDeadlines() == 0,
+           "missed %llu deadlines",
+           (unsigned long long)pacer.MissedDeadlines());
+    Expect(pacer.NextDeadline() == t0 + (frames + 1) * pacer.Period(),
+           "deadline drifted by %lld us",
+           (long long)(pacer.NextDeadline() - t0 -
+                       (frames + 1) * pacer.Period()));
+    Expect(worst > 0 && worst < pacer.Period(),
+           "worst lateness %lld",
+           (long long)worst);
+}
+
+// 晚醒超过一个周期：晚了几整个周期就记几次错过，下一个截止时间还在原来的节拍上
+static void Missed(uint32_t seed)
+{
+    printf("  jitter beyond one period\n");
+    SimClock   clock(seed);
+    FramePacer pacer(clock);
+    pacer.SetTargetFps(120.0);
+    clock.SetJitter(pacer.Period() * 5 / 2);
+
+    int64_t  t0       = pacer.WaitNextFrame();
+    uint64_t expected = 0;
+    bool     aligned  = true;
+    for (int k = 0; k < 50000; ++k)
+    {
+        int64_t start = pacer.WaitNextFrame();
+        expected += (uint64_t)((start - clock.LastDeadline()) / pacer.Period());
+        aligned = aligned && (pacer.NextDeadline() - t0) % pacer.Period() == 0;
+    }
+
+    Expect(expected > 0, "jitter never skipped a frame");
+    Expect(pacer.MissedDeadlines() == expected,
+           "missed %llu, expected %llu",
+           (unsigned long long)pacer.MissedDeadlines(),
+           (unsigned long long)expected);
+    Expect(aligned, "deadlines left the original beat");
+}
+
+// 醒早了 (调用方没等够)：当准点算，不记错过，后面的节拍也不提前
+static void Early(uint32_t seed)
+{
+    printf("  early wake-ups\n");
+    SimClock   clock(seed);
+    FramePacer pacer(clock);
+    pacer.SetTargetFps(60.0);
+    clock.SetEarly(500);
+
+    int64_t t0 = pacer.WaitNextFrame();
+    for (int k = 1; k <= 1000; ++k)
+        pacer.WaitNextFrame();
+
+    Expect(pacer.MissedDeadlines() == 0,
+           "missed %llu deadlines",
+           (unsigned long long)pacer.MissedDeadlines());
+    Expect(pacer.LastLateness() == 0,
+           "lateness %lld",
+           (long long)pacer.LastLateness());
+    Expect(pacer.NextDeadline() == t0 + 1001 * pacer.Period(),
+           "deadline drifted by %lld us",
+           (long long)(pacer.NextDeadline() - t0 - 1001 * pacer.Period()));
+}
+
+// 中途改帧率 (换显示器、改刷新率)：从改的那一刻按新的间隔重新排，
+// 改之前欠的不算错过；超出 1~1000 的夹住
+static void FpsChange(uint32_t seed)
+{
+    printf("  target fps changes\n");
+    SimClock   clock(seed);
+    FramePacer pacer(clock);
+
+    const double  rates[]   = {60.0, 144.0, 30.0, 0.0, 5000.0, 75.0};
+    const int64_t periods[] = {16667, 6944, 33333, 1000000, 1000, 13333};
+
+    for (int r = 0; r < 6; ++r)
+    {
+        pacer.SetTargetFps(rates[r]);
+        Expect(pacer.Period() == periods[r],
+               "fps %.0f: period %lld, expected %lld",
+               rates[r],
+               (long long)pacer.Period(),
+               (long long)periods[r]);
+
+        // 改完第一帧从现在开始：不等，也不算晚
+        int64_t before = clock.Now();
+        int64_t t0     = pacer.WaitNextFrame();
+        Expect(t0 == before && pacer.LastLateness() == 0,
+               "fps %.0f: first frame waited %lld us",
+               rates[r],
+               (long long)(t0 - before));
+
+        bool exact = true;
+        for (int k = 1; k <= 200; ++k)
+            exact = exact && pacer.WaitNextFrame() == t0 + k * pacer.Period();
+        Expect(exact, "fps %.0f: frames not spaced by the period", rates[r]);
+
+        // 下一次改之前过了好几帧的时间：改帧率会重新排，这段不该算错过
+        clock.Skip(pacer.Period() * 3);
+    }
+
+    Expect(pacer.MissedDeadlines() == 0,
+           "missed %llu deadlines across fps changes",
+           (unsigned long long)pacer.MissedDeadlines());
+}
+
+// 卡了好几秒 (拖窗口、休眠)：错过的帧一次记清，节拍不变；
+// 模拟最多补 MAX_STEPS 步，剩下的丢掉
+static void Stall(uint32_t seed)
+{
+    printf("  long stall\n");
+    SimClock   clock(seed);
+    FramePacer pacer(clock);
+    StepCheck  steps;
+    pacer.SetTargetFps(60.0);
+    clock.SetJitter(2000);
+
+    int64_t t0 = pacer.WaitNextFrame();
+    steps.Frame(t0);
+    for (int k = 0; k < 300; ++k)
+        steps.Frame(pacer.WaitNextFrame());
+    Expect(steps.step.DroppedSteps() == 0,
+           "dropped %llu steps before the stall",
+           (unsigned long long)steps.step.DroppedSteps());
+
+    const int64_t stall = 2500000;
+    uint64_t      was   = pacer.MissedDeadlines();
+    clock.Stall(stall);
+    int64_t start = pacer.WaitNextFrame();
+    int     n     = steps.Frame(start);
+
+    uint64_t expected = (uint64_t)((start - clock.LastDeadline()) /
+                                   pacer.Period());
+    Expect(pacer.MissedDeadlines() - was == expected && expected >= 149,
+           "stall missed %llu, expected %llu",
+           (unsigned long long)(pacer.MissedDeadlines() - was),
+           (unsigned long long)expected);
+    Expect((pacer.NextDeadline() - t0) % pacer.Period() == 0,
+           "deadlines left the original beat after the stall");
+    Expect(n == MAX_STEPS, "caught up %d steps, expected %d", n, MAX_STEPS);
+    Expect(steps.step.DroppedSteps() >= (uint64_t)(stall / SIM_STEP_US) - 3,
+           "dropped only %llu steps",
+           (unsigned long long)steps.step.DroppedSteps());
+
+    // 卡完以后回到每帧 0~1 步，不再补
+    uint64_t dropped = steps.step.DroppedSteps();
+    for (int k = 0; k < 300; ++k)
+        Expect(steps.Frame(pacer.WaitNextFrame()) <= 1, "kept catching up");
+    Expect(steps.step.DroppedSteps() == dropped, "dropped steps after stall");
+    Expect(steps.ok, "simulation time left [now - step, now]");
+}
+
+// 显示帧率比模拟快 (144) 和慢 (20)：模拟一直按 30 步每秒走，不丢步
+static void FixedRate(uint32_t seed)
+{
+    const double rates[] = {144.0, 20.0};
+    for (double fps : rates)
+    {
+        printf("  fixed step at %.0f fps\n", fps);
+        SimClock   clock(seed);
+        FramePacer pacer(clock);
+        StepCheck  steps;
+        pacer.SetTargetFps(fps);
+        clock.SetJitter(pacer.Period() / 2);
+
+        int64_t t0 = pacer.WaitNextFrame();
+        steps.Frame(t0);
+        int64_t now = t0;
+        while (now - t0 < 60000000)
+        {
+            now = pacer.WaitNextFrame();
+            steps.Frame(now);
+        }
+
+        // 第一帧跑一步，之后每满一步跑一步
+        uint64_t expected = (uint64_t)((now - t0) / SIM_STEP_US) + 1;
+        Expect(steps.step.Steps() == expected,
+               "ran %llu steps in 60 s, expected %llu",
+               (unsigned long long)steps.step.Steps(),
+               (unsigned long long)expected);
+        Expect(steps.step.DroppedSteps() == 0,
+               "dropped %llu steps",
+               (unsigned long long)steps.step.DroppedSteps());
+        Expect(steps.most <= (fps > 30.0 ? 1 : 2),
+               "up to %d steps in one frame",
+               steps.most);
+        Expect(steps.ok, "simulation time left [now - step, now]");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1;
+
+    printf("pacer_sim, seed %u\n", seed);
+    Steady(seed);
+    Jitter(seed);
+    Missed(seed);
+    Early(seed);
+    FpsChange(seed);
+    Stall(seed);
+    FixedRate(seed);
+
+    if (s_failures > 0)
+    {
+        printf("FAILED: %d checks\n", s_failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,114 @@
+// 模拟线程 -> 渲染线程的快照交接 (SnowSnapshot.h 的 TripleBuffer) 的压力测试：
+// 一个线程不停地写快照、Publish，另一个线程空转着 Acquire，
+// 检查拿到的每一帧都是完整的 (没有撕裂)，而且帧号只往前走
+// 不依赖 Windows，Linux 上这样编译：
+//   g++ -O2 -std=c++17 -pthread -I../src -o snapshot_stress
+//       SnapshotStress.cpp
+//   (写在一行里；查数据竞争再加 -g -fsanitize=thread)
+// 用法：snapshot_stress [帧数]
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include "SnowSnapshot.h"
+
+// 第 tick 帧有几颗：长短来回变，vector 时大时小，旧数据留在容量里
+static uint32_t CountOf(uint32_t tick)
+{
+    return 1 + (tick * 7919) % 3000;
+}
+
+// 第 tick 帧的内容都带着帧号，读的一方据此检查是不是同一帧写出来的
+static void Fill(SnowSnapshot &snapshot, uint32_t tick)
+{
+    uint32_t n = CountOf(tick);
+    snapshot.sprites.resize(n);
+    for (uint32_t i = 0; i < n; ++i)
+        snapshot.sprites[i] = {(float)tick, (float)i, 1.0f, 1.0f};
+
+    snapshot.landed.resize(n / 4);
+    for (auto &landed : snapshot.landed)
+        landed = {{(float)tick, 0.0f, 1.0f, 1.0f}, tick};
+
+    snapshot.layers.assign(1, {0.0f, (float)tick, 1.0f, 0, n / 4});
+
+    snapshot.tick           = tick;
+    snapshot.surfaceVersion = tick;
+    snapshot.screenWidth    = (int)n;
+    snapshot.screenHeight   = (int)tick;
+}
+
+static bool Consistent(const SnowSnapshot &snapshot)
+{
+    uint32_t tick = snapshot.tick;
+    uint32_t n    = CountOf(tick);
+    if (snapshot.sprites.size() != n || snapshot.landed.size() != n / 4 ||
+        snapshot.layers.size() != 1 || snapshot.surfaceVersion != tick ||
+        snapshot.screenWidth != (int)n || snapshot.screenHeight != (int)tick)
+        return false;
+
+    for (const auto &sprite : snapshot.sprites)
+    {
+        if (sprite.x != (float)tick)
+            return false;
+    }
+    for (const auto &landed : snapshot.landed)
+    {
+        if (landed.landTick != tick || landed.sprite.x != (float)tick)
+            return false;
+    }
+
+    const SnowLayer &layer = snapshot.layers[0];
+    return layer.top == (float)tick && layer.count == n / 4;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = argc > 1 ? (uint32_t)atol(argv[1]) : 2000000;
+
+    TripleBuffer<SnowSnapshot> buffers;
+    std::atomic<bool>          done{false};
+
+    uint64_t dropped = 0;  // 没被取走就被顶掉的帧 (渲染跟不上，正常)
+    std::thread producer([&] {
+        for (uint32_t tick = 1; tick <= frames; ++tick)
+        {
+            Fill(buffers.WriteBuffer(), tick);
+            if (buffers.Publish())
+                ++dropped;
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t acquired  = 0;
+    uint64_t torn      = 0;  // 拿到的快照不是同一帧的 (必须是 0)
+    uint64_t backwards = 0;  // 帧号没往前走 (必须是 0)
+    uint32_t last      = 0;
+
+    // 生产者写完以后再取一次，最后一帧不能丢
+    for (bool finished = false; !finished;)
+    {
+        finished = done.load(std::memory_order_acquire);
+        if (!buffers.Acquire())
+            continue;
+
+        const SnowSnapshot &snapshot = buffers.ReadBuffer();
+        ++acquired;
+        if (!Consistent(snapshot))
+            ++torn;
+        if (snapshot.tick <= last)
+            ++backwards;
+        last = snapshot.tick;
+    }
+    producer.join();
+
+    printf("frames %u\n", frames);
+    printf("  acquired           %llu\n", (unsigned long long)acquired);
+    printf("  dropped (skipped)  %llu\n", (unsigned long long)dropped);
+    printf("  torn               %llu\n", (unsigned long long)torn);
+    printf("  out of order       %llu\n", (unsigned long long)backwards);
+    printf("  last tick          %u\n", last);
+
+    bool ok = torn == 0 && backwards == 0 && last == frames;
+    return ok ? 0 : 1;
+}
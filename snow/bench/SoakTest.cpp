@@ -0,0 +1,522 @@
+// 长时间运行的浸泡测试：把几天、几周的运行压缩成几分钟
+// 引擎 + 合成桌面 (窗口不停地挪、开、关) 按固定步长能跑多快跑多快，
+// 每隔几个模拟小时报一次：帧耗时分位数、内存、堆分配次数，再查一遍状态的不变量
+// 只有开了很多天才冒出来的问题 (雪花数组来回折腾、相位越加越大丢精度、
+// 障碍物每次刷新都漏一点内存……) 只能这样提前发现
+//
+// 不依赖 Windows，Linux 上这样编译：
+//   g++ -O2 -std=c++17 -pthread -I../src -o snow_soak
+//       SoakTest.cpp SyntheticDesktop.cpp ../src/ObstacleFinder.cpp
+//       ../src/SnowEngine.cpp ../src/WindField.cpp ../src/FlakeGrid.cpp
+//       ../src/CompactFlake.cpp ../src/SurfaceEdges.cpp
+//       ../src/ObstacleDiff.cpp ../src/StateFile.cpp
+//   (写在一行里)
+// 用法：snow_soak [选项]
+//   --days=D          模拟多少天 (默认 7)
+//   --report=H        每隔几个模拟小时报一次 (默认 6)
+//   --count=C         雪花数 (默认 1000)
+//   --compact         紧凑存储
+//   --windows=N       合成桌面上的顶层窗口数 (默认 60)
+//   --seed=S
+//   --max-slowdown=R  帧耗时中位数比第一次报告慢了 R 倍就算失败 (默认 1.5)
+//   --csv=path        每次报告再写一行 CSV，方便画趋势
+// 第一次报告 (雪花撒满、各种缓冲长到稳定大小以后) 当基准，
+// 之后内存、堆、每帧分配次数涨了，帧耗时变慢了，或者不变量被破坏，返回 1
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include <unistd.h>
+#include "SnowEngine.h"
+#include "StateFile.h"
+#include "ObstacleFinder.h"
+#include "SyntheticDesktop.h"
+
+// 引擎里鼠标互动的开关在 Main.cpp 里
+bool g_bEnableMouseInteraction = true;
+
+// ---------------------------------------------------------
+//  数一数堆分配：替换全局的 new / delete
+// ---------------------------------------------------------
+
+static std::atomic<uint64_t> s_allocs{0};
+static std::atomic<int64_t>  s_heapBytes{0};
+
+static void *CountedAlloc(size_t size)
+{
+    void *p = malloc(size ? size : 1);
+    if (p)
+    {
+        s_allocs.fetch_add(1, std::memory_order_relaxed);
+        s_heapBytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    }
+    return p;
+}
+
+static void CountedFree(void *p)
+{
+    if (!p)
+        return;
+    s_heapBytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    free(p);
+}
+
+void *operator new(size_t size)
+{
+    void *p = CountedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { CountedFree(p); }
+void operator delete[](void *p) noexcept { CountedFree(p); }
+void operator delete(void *p, size_t) noexcept { CountedFree(p); }
+void operator delete[](void *p, size_t) noexcept { CountedFree(p); }
+
+// ---------------------------------------------------------
+//  参数和统计
+// ---------------------------------------------------------
+
+// 和真正跑起来一样的节奏：一步 33ms，障碍物 500ms 刷新一次
+static const int TICKS_PER_SECOND = 30;
+static const int REFRESH_TICKS    = 15;
+static const int CHURN_TICKS      = 5 * TICKS_PER_SECOND;   // 每 5 秒动一下桌面
+static const int SWIPE_TICKS      = 60 * TICKS_PER_SECOND;  // 每分钟划一下鼠标
+static const int SWIPE_LENGTH     = TICKS_PER_SECOND;
+static const int HOUR_TICKS       = 3600 * TICKS_PER_SECOND;
+
+static const int SCREEN_WIDTH  = 1920;
+static const int SCREEN_HEIGHT = 1080;
+
+struct SoakOptions
+{
+    double      days        = 7.0;
+    double      reportHours = 6.0;
+    int         count       = 1000;
+    bool        compact     = false;
+    int         windows     = 60;
+    unsigned    seed        = 1;
+    double      maxSlowdown = 1.5;
+    std::string csv;
+};
+
+// 一个报告周期的统计
+struct SoakReport
+{
+    double p50  = 0.0;  // 每一步 (Update + BuildSnapshot) 的耗时，微秒
+    double p99  = 0.0;
+    double p999 = 0.0;
+    double max  = 0.0;
+
+    double  allocsPerTick = 0.0;
+    int64_t heapBytes     = 0;
+    int64_t rssBytes      = 0;
+
+    size_t landed = 0;
+};
+
+static int64_t ResidentBytes()
+{
+    long  pages = 0, resident = 0;
+    FILE *fp    = fopen("/proc/self/statm", "r");
+    if (!fp)
+        return 0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(fp);
+    return (int64_t)resident * sysconf(_SC_PAGESIZE);
+}
+
+// 每一步耗时的直方图：按 1% 一档对数分桶 (1 微秒到 10 秒)，
+// 不用把几百万个样本都存下来 (存下来的话，它自己就是堆上最大的一块)
+// 分位数取那一档的上沿，误差不超过 1%
+class LatencyHistogram
+{
+  public:
+    void Add(double us)
+    {
+        int b = us <= 1.0 ? 0 : (int)(std::log(us) / LOG_STEP) + 1;
+        if (b >= BUCKETS)
+            b = BUCKETS - 1;
+        ++m_counts[b];
+        ++m_total;
+        if (us > m_max)
+            m_max = us;
+    }
+
+    // 从小到大第 q 分位
+    double Percentile(double q) const
+    {
+        uint64_t rank = (uint64_t)(q * (double)(m_total - 1));
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b)
+        {
+            seen += m_counts[b];
+            if (seen > rank)
+                return std::exp(b * LOG_STEP);
+        }
+        return m_max;
+    }
+
+    uint64_t Count() const { return m_total; }
+    double   Max() const { return m_max; }
+
+    void Clear()
+    {
+        memset(m_counts, 0, sizeof(m_counts));
+        m_total = 0;
+        m_max   = 0.0;
+    }
+
+  private:
+    static constexpr double LOG_STEP = 0.00995033;  // ln(1.01)
+    static const int        BUCKETS  = 1624;        // ln(1e7) / ln(1.01)
+
+    uint64_t m_counts[BUCKETS] = {};
+    uint64_t m_total           = 0;
+    double   m_max             = 0.0;
+};
+
+// ---------------------------------------------------------
+//  不变量
+// ---------------------------------------------------------
+
+// 每颗雪花都还是个正常的数：位置速度有限、相位在一圈以内、没有比原来还大
+static bool CheckFlakes(const std::vector<uint8_t> &state, std::string &error)
+{
+    SnowStateHeader header;
+    memcpy(&header, state.data(), sizeof(header));
+
+    // 紧凑存储的相位是 16 位定点，本来就转不出一圈，位置也是定点，不用查
+    if (header.flags & STATE_FLAG_COMPACT)
+        return true;
+
+    const uint8_t *p = state.data() + sizeof(header) + header.rngSize;
+    for (uint32_t i = 0; i < header.flakeCount; ++i)
+    {
+        Snowflake s;
+        memcpy(&s, p + (size_t)i * sizeof(Snowflake), sizeof(s));
+
+        if (!std::isfinite(s.x) || !std::isfinite(s.y) ||
+            !std::isfinite(s.vx) || !std::isfinite(s.vy))
+        {
+            error = "flake position or velocity is not finite";
+            return false;
+        }
+        if (!(s.angle >= 0.0f && s.angle < 6.2831853f + 0.1f))
+        {
+            error = "flake swing phase left [0, 2pi): " +
+                    std::to_string(s.angle);
+            return false;
+        }
+        if (!(s.size >= 0.0f && s.size <= s.maxSize + 0.001f))
+        {
+            error = "flake size outside [0, maxSize]";
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool CheckInvariants(const SnowEngine          &engine,
+                            const SnowSnapshot        &snapshot,
+                            size_t                     target,
+                            const std::vector<uint8_t> &state,
+                            std::string               &error)
+{
+    if (engine.FlakeCount() != target)
+    {
+        error = "flake count " + std::to_string(engine.FlakeCount()) +
+                " != " + std::to_string(target);
+        return false;
+    }
+    if (engine.LandedCount() > engine.FlakeCount() ||
+        snapshot.sprites.size() + snapshot.landed.size() > engine.FlakeCount())
+    {
+        error = "more landed / visible flakes than flakes";
+        return false;
+    }
+    for (const auto &sp : snapshot.sprites)
+    {
+        if (!std::isfinite(sp.x) || !std::isfinite(sp.y) || !(sp.size > 0.0f) ||
+            !(sp.opacity >= 0.0f && sp.opacity <= 1.0f))
+        {
+            error = "bad sprite in snapshot";
+            return false;
+        }
+    }
+    return CheckFlakes(state, error);
+}
+
+// ---------------------------------------------------------
+//  主循环
+// ---------------------------------------------------------
+
+static bool ParseOptions(int argc, char **argv, SoakOptions &opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--days=", 7) == 0)
+            opt.days = atof(arg + 7);
+        else if (strncmp(arg, "--report=", 9) == 0)
+            opt.reportHours = atof(arg + 9);
+        else if (strncmp(arg, "--count=", 8) == 0)
+            opt.count = atoi(arg + 8);
+        else if (strcmp(arg, "--compact") == 0)
+            opt.compact = true;
+        else if (strncmp(arg, "--windows=", 10) == 0)
+            opt.windows = atoi(arg + 10);
+        else if (strncmp(arg, "--seed=", 7) == 0)
+            opt.seed = (unsigned)strtoul(arg + 7, nullptr, 10);
+        else if (strncmp(arg, "--max-slowdown=", 15) == 0)
+            opt.maxSlowdown = atof(arg + 15);
+        else if (strncmp(arg, "--csv=", 6) == 0)
+            opt.csv = arg + 6;
+        else
+            return false;
+    }
+    return opt.days > 0.0 && opt.reportHours > 0.0 && opt.count >= 0 &&
+           opt.windows >= 0;
+}
+
+int main(int argc, char **argv)
+{
+    SoakOptions opt;
+    if (!ParseOptions(argc, argv, opt))
+    {
+        fprintf(stderr,
+                "usage: snow_soak [--days=D] [--report=H] [--count=C] "
+                "[--compact] [--windows=N] [--seed=S] [--max-slowdown=R] "
+                "[--csv=path]\n");
+        return 2;
+    }
+
+    FILE *csv = nullptr;
+    if (!opt.csv.empty())
+    {
+        csv = fopen(opt.csv.c_str(), "w");
+        if (!csv)
+        {
+            fprintf(stderr, "cannot open %s\n", opt.csv.c_str());
+            return 2;
+        }
+        fprintf(csv,
+                "hours,p50_us,p99_us,p999_us,max_us,allocs_per_tick,"
+                "heap_bytes,rss_bytes,landed\n");
+    }
+
+    SyntheticDesktop desktop;
+    desktop.Generate(SyntheticDesktop::LAYOUT_OVERLAPPING,
+                     opt.windows,
+                     SCREEN_WIDTH,
+                     SCREEN_HEIGHT,
+                     opt.seed);
+    desktop.SetCornerRadius(8);
+    ObstacleFinder finder;
+
+    SnowEngine engine(opt.seed);
+    engine.SetCompactStorage(opt.compact);
+    engine.SetTurbulence(0.5f);
+    engine.Initialize(SCREEN_WIDTH, SCREEN_HEIGHT, opt.count);
+
+    // 设置窗口里拖滑块：每个报告周期在原数量和 3/4 之间来回切
+    size_t target = engine.FlakeCount();
+
+    std::vector<Obstacle> obstacles;
+    std::vector<POINT>    mousePath;
+    SnowSnapshot          snapshot;
+    std::vector<uint8_t>  state;
+    SnowEngine            reloaded(opt.seed);
+
+    uint64_t reportTicks =
+        (uint64_t)(opt.reportHours * 3600.0 * TICKS_PER_SECOND + 0.5);
+    uint64_t totalTicks =
+        (uint64_t)(opt.days * 24.0 * 3600.0 * TICKS_PER_SECOND);
+    if (reportTicks == 0)
+        reportTicks = 1;
+
+    LatencyHistogram latency;
+    uint64_t         engineAllocs = 0;
+
+    printf("%9s %8s %8s %8s %8s %11s %12s %10s %7s\n",
+           "hours",
+           "p50 us",
+           "p99 us",
+           "p99.9 us",
+           "max us",
+           "allocs/tick",
+           "heap",
+           "rss",
+           "landed");
+
+    using Clock = std::chrono::steady_clock;
+    auto wallStart = Clock::now();
+
+    SoakReport  baseline;
+    bool        hasBaseline = false;
+    bool        failed      = false;
+    uint64_t    tick        = 0;
+    std::string error;
+
+    for (; tick < totalTicks && !failed; ++tick)
+    {
+        // --- 桌面和用户的动作 ---
+        if (tick % CHURN_TICKS == 0 && tick > 0)
+            desktop.Churn();
+        if (tick % REFRESH_TICKS == 0)
+            obstacles = finder.FindCached(desktop);
+
+        // 鼠标从左往右划过去一秒 (MouseTracker 每帧给的是这一帧走过的折线)
+        mousePath.clear();
+        uint64_t swipe = tick % SWIPE_TICKS;
+        if (swipe < SWIPE_LENGTH)
+        {
+            LONG x0 = (LONG)(swipe * SCREEN_WIDTH / SWIPE_LENGTH);
+            LONG x1 = (LONG)((swipe + 1) * SCREEN_WIDTH / SWIPE_LENGTH);
+            mousePath.push_back({x0, SCREEN_HEIGHT / 2});
+            mousePath.push_back({x1, SCREEN_HEIGHT / 2});
+        }
+
+        // 风每个模拟小时转一圈
+        float hour = (float)(tick % HOUR_TICKS) / HOUR_TICKS;
+        engine.SetWind(2.0f * sinf(hour * 6.2831853f));
+
+        // --- 模拟一步 (只数引擎自己的分配，不算上面合成桌面的) ---
+        uint64_t allocs = s_allocs.load(std::memory_order_relaxed);
+        auto     start  = Clock::now();
+        engine.Update(SCREEN_WIDTH, SCREEN_HEIGHT, obstacles, mousePath);
+        engine.BuildSnapshot(snapshot);
+        latency.Add(std::chrono::duration<double, std::micro>(
+                        Clock::now() - start)
+                        .count());
+        engineAllocs += s_allocs.load(std::memory_order_relaxed) - allocs;
+
+        if ((tick + 1) % reportTicks != 0 && tick + 1 != totalTicks)
+            continue;
+
+        // --- 报告 ---
+        SoakReport report;
+        report.p50           = latency.Percentile(0.50);
+        report.p99           = latency.Percentile(0.99);
+        report.p999          = latency.Percentile(0.999);
+        report.max           = latency.Max();
+        report.allocsPerTick = (double)engineAllocs / latency.Count();
+        report.heapBytes     = s_heapBytes.load();
+        report.rssBytes      = ResidentBytes();
+        report.landed        = engine.LandedCount();
+
+        double hours = (double)(tick + 1) / TICKS_PER_SECOND / 3600.0;
+        printf("%9.1f %8.2f %8.2f %8.2f %8.1f %11.3f %12lld %10lld %7zu\n",
+               hours,
+               report.p50,
+               report.p99,
+               report.p999,
+               report.max,
+               report.allocsPerTick,
+               (long long)report.heapBytes,
+               (long long)report.rssBytes,
+               report.landed);
+        fflush(stdout);
+        if (csv)
+        {
+            fprintf(csv,
+                    "%.2f,%.3f,%.3f,%.3f,%.3f,%.4f,%lld,%lld,%zu\n",
+                    hours,
+                    report.p50,
+                    report.p99,
+                    report.p999,
+                    report.max,
+                    report.allocsPerTick,
+                    (long long)report.heapBytes,
+                    (long long)report.rssBytes,
+                    report.landed);
+            fflush(csv);
+        }
+
+        // 不变量 (存档本身也得能读回来)
+        engine.SaveState(state);
+        if (!CheckInvariants(engine, snapshot, target, state, error))
+            failed = true;
+        else if (!reloaded.LoadState(
+                     state.data(), state.size(), SCREEN_WIDTH, SCREEN_HEIGHT))
+        {
+            error  = "saved state does not load back";
+            failed = true;
+        }
+
+        // 跟第一次报告比：内存和堆只许有一点零头的浮动
+        if (!failed && hasBaseline)
+        {
+            int64_t heapSlack =
+                std::max<int64_t>(1 << 20, baseline.heapBytes / 10);
+            int64_t rssSlack =
+                std::max<int64_t>(8 << 20, baseline.rssBytes / 10);
+            if (report.heapBytes > baseline.heapBytes + heapSlack)
+                error = "heap grew since the first report";
+            else if (report.rssBytes > baseline.rssBytes + rssSlack)
+                error = "resident memory grew since the first report";
+            else if (report.allocsPerTick > baseline.allocsPerTick * 1.5 + 0.5)
+                error = "more allocations per tick than at the first report";
+            else if (report.p50 > baseline.p50 * opt.maxSlowdown)
+                error = "median tick time slowed down";
+            failed = !error.empty();
+        }
+        if (!hasBaseline)
+        {
+            baseline    = report;
+            hasBaseline = true;
+        }
+
+        // 滑块来回拖一下 (补雪是在计时外面调的，不算进下一个周期)
+        if (opt.count > 0)
+        {
+            size_t full = (size_t)opt.count;
+            size_t next = target == full ? full * 3 / 4 : full;
+            engine.SetFlakeCount((int)next);
+            target = engine.FlakeCount();
+        }
+
+        latency.Clear();
+        engineAllocs = 0;
+    }
+
+    double wall =
+        std::chrono::duration<double>(Clock::now() - wallStart).count();
+    double simulated = (double)tick / TICKS_PER_SECOND;
+    printf("%.2f simulated days in %.1f s (%.0fx real time)\n",
+           simulated / 86400.0,
+           wall,
+           simulated / wall);
+
+    if (csv)
+        fclose(csv);
+
+    if (failed)
+    {
+        printf("FAILED: %s\n", error.c_str());
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
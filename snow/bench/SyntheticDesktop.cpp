@@ -0,0 +1,257 @@
+#include "SyntheticDesktop.h"
+#include <random>
+#include <cmath>
+#include <cwchar>
+#include <algorithm>
+#include "SurfaceMask.h"
+
+static const int TASKBAR_HEIGHT = 40;
+
+const char *SyntheticDesktop::LayoutName(Layout layout)
+{
+    switch (layout)
+    {
+    case LAYOUT_TILED:
+        return "tiled";
+    case LAYOUT_CASCADED:
+        return "cascaded";
+    case LAYOUT_MAXIMIZED:
+        return "maximized";
+    case LAYOUT_OVERLAPPING:
+        return "overlapping";
+    default:
+        return "?";
+    }
+}
+
+void SyntheticDesktop::Generate(Layout   layout,
+                                int      count,
+                                int      screenWidth,
+                                int      screenHeight,
+                                unsigned seed)
+{
+    std::mt19937 rng(seed);
+    m_windows.clear();
+    m_nextId = 0;
+    m_rng.seed(seed);
+
+    int workHeight = screenHeight - TASKBAR_HEIGHT;
+    m_taskbar      = {0, workHeight, screenWidth, screenHeight};
+    m_screenWidth  = screenWidth;
+    m_workHeight   = workHeight;
+
+    // 最上面是我们自己的覆盖窗口，最下面是桌面 (Progman / WorkerW)
+    RECT screen = {0, 0, screenWidth, screenHeight};
+    Add(screen, true, false, L"SnowWindowClass");
+
+    // 真实桌面上一大半顶层窗口是看不见的 (托盘、输入法、后台程序……)
+    // 这里按 1/4 隐藏、1/16 最小化来撒，剩下的才按布局摆放
+    int apps = count < 3 ? 0 : count - 3;
+    std::vector<int> kinds(apps);
+    int              shown = 0;
+    for (int i = 0; i < apps; ++i)
+    {
+        unsigned r = rng() % 16;
+        kinds[i]   = r < 4 ? 0 : (r == 4 ? 1 : 2);  // 0 隐藏, 1 最小化, 2 正常
+        shown += kinds[i] == 2;
+    }
+
+    int cols = (int)std::ceil(std::sqrt((double)(shown > 0 ? shown : 1)));
+    int rows = (shown + cols - 1) / (cols > 0 ? cols : 1);
+    rows     = rows > 0 ? rows : 1;
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    int k = 0;  // 第几个正常显示的窗口 (从上往下数)
+    for (int i = 0; i < apps; ++i)
+    {
+        if (kinds[i] != 2)
+        {
+            // 看不见的窗口随便给个位置，反正会被过滤掉
+            RECT rc = {100, 100, 500, 400};
+            Add(rc, kinds[i] == 1, kinds[i] == 1, L"App");
+            continue;
+        }
+
+        RECT rc;
+        switch (layout)
+        {
+        case LAYOUT_TILED: {
+            int cellW = screenWidth / cols;
+            int cellH = workHeight / rows;
+            int c     = k % cols;
+            int r     = k / cols;
+            rc        = {c * cellW, r * cellH, (c + 1) * cellW, (r + 1) * cellH};
+            break;
+        }
+        case LAYOUT_CASCADED: {
+            // 越晚打开的越靠上，也越靠右下
+            int w     = screenWidth * 6 / 10;
+            int h     = workHeight * 6 / 10;
+            int steps = shown - 1 - k;
+            int x     = (steps * 30) % (screenWidth - w);
+            int y     = (steps * 30) % (workHeight - h);
+            rc        = {x, y, x + w, y + h};
+            break;
+        }
+        case LAYOUT_MAXIMIZED:
+            rc = {0, 0, screenWidth, workHeight};
+            break;
+        default: {
+            int w = (int)(screenWidth * (0.3f + 0.5f * unit(rng)));
+            int h = (int)(workHeight * (0.3f + 0.5f * unit(rng)));
+            int x = (int)((screenWidth - w) * unit(rng));
+            int y = (int)((workHeight - h) * unit(rng));
+            rc    = {x, y, x + w, y + h};
+            break;
+        }
+        }
+
+        Add(rc, true, false, L"App");
+        ++k;
+    }
+
+    Add(screen, true, false, L"WorkerW");
+    Add(screen, true, false, L"Progman");
+    Reindex();
+    m_apps = apps;
+}
+
+void SyntheticDesktop::Add(const RECT    &frame,
+                           bool           visible,
+                           bool           minimized,
+                           const wchar_t *cls)
+{
+    m_windows.push_back({frame, visible, minimized, cls, m_nextId++});
+}
+
+void SyntheticDesktop::Reindex()
+{
+    m_position.clear();
+    for (size_t i = 0; i < m_windows.size(); ++i)
+        m_position[m_windows[i].id] = i;
+}
+
+void SyntheticDesktop::Churn()
+{
+    // 应用窗口夹在最上面的覆盖窗口和最下面的两个桌面窗口之间
+    size_t first = 1;
+    size_t last  = m_windows.size() - 2;
+    if (last < first)
+        return;
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    unsigned action = m_rng() % 20;
+    size_t   apps   = last - first;
+    size_t   i      = apps > 0 ? first + m_rng() % apps : first;
+
+    if (apps == 0 || (action < 4 && apps <= m_apps))
+    {
+        // 新开一个窗口，放在最上面
+        int  w  = (int)(m_screenWidth * (0.3f + 0.5f * unit(m_rng)));
+        int  h  = (int)(m_workHeight * (0.3f + 0.5f * unit(m_rng)));
+        int  x  = (int)((m_screenWidth - w) * unit(m_rng));
+        int  y  = (int)((m_workHeight - h) * unit(m_rng));
+        RECT rc = {x, y, x + w, y + h};
+        m_windows.insert(m_windows.begin() + first,
+                         {rc, true, false, L"App", m_nextId++});
+    }
+    else if (action < 4)
+    {
+        m_windows.erase(m_windows.begin() + i);
+    }
+    else if (action < 16)
+    {
+        // 拖一下：在屏幕里挪一段 (比屏幕还大的就不动了)
+        Window &win = m_windows[i];
+        LONG    w   = win.frame.right - win.frame.left;
+        LONG    h   = win.frame.bottom - win.frame.top;
+        if (w >= m_screenWidth || h >= m_workHeight)
+            return;
+
+        LONG x = win.frame.left + (LONG)(m_rng() % 401) - 200;
+        LONG y = win.frame.top + (LONG)(m_rng() % 401) - 200;
+        x      = std::max<LONG>(0, std::min<LONG>(x, m_screenWidth - w));
+        y      = std::max<LONG>(0, std::min<LONG>(y, m_workHeight - h));
+        win.frame = {x, y, x + w, y + h};
+        return;  // 顺序没变，不用重建下标
+    }
+    else if (action < 18)
+    {
+        // 点一下，提到最上面
+        std::rotate(m_windows.begin() + first,
+                    m_windows.begin() + i,
+                    m_windows.begin() + i + 1);
+    }
+    else
+    {
+        Window &win = m_windows[i];
+        if (win.visible)
+            win.minimized = !win.minimized;
+        return;
+    }
+
+    Reindex();
+}
+
+bool SyntheticDesktop::GetTaskbar(RECT &rc)
+{
+    ++m_queries;
+    rc = m_taskbar;
+    return true;
+}
+
+void SyntheticDesktop::Enumerate(WindowVisitor visit, void *ctx)
+{
+    for (size_t i = 0; i < m_windows.size(); ++i)
+    {
+        if (!visit(m_windows[i].id, ctx))
+            break;
+    }
+}
+
+bool SyntheticDesktop::IsVisible(WindowId window)
+{
+    ++m_queries;
+    return At(window).visible;
+}
+
+bool SyntheticDesktop::IsMinimized(WindowId window)
+{
+    ++m_queries;
+    return At(window).minimized;
+}
+
+void SyntheticDesktop::GetClass(WindowId window, wchar_t *name, int size)
+{
+    ++m_queries;
+    wcsncpy(name, At(window).className, size - 1);
+    name[size - 1] = L'\0';
+}
+
+void SyntheticDesktop::GetFrame(WindowId window, RECT &rc)
+{
+    ++m_queries;
+    ++m_frameQueries;
+    rc = At(window).frame;
+}
+
+void SyntheticDesktop::GetBounds(WindowId window, RECT &rc)
+{
+    ++m_queries;
+    rc = At(window).frame;
+}
+
+// 所有窗口都是同样的圆角，不用看是哪个
+bool SyntheticDesktop::GetTopMask(WindowId,
+                                  const RECT            &frame,
+                                  std::vector<uint64_t> &bits)
+{
+    ++m_queries;
+    if (m_cornerRadius <= 0)
+        return false;
+
+    SurfaceMask::RoundedCorners(bits, frame.right - frame.left, m_cornerRadius);
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <random>
+#include <unordered_map>
+#include "WindowSource.h"
+
+// 合成的桌面：按指定的布局生成一叠 Z 顺序排好的顶层窗口
+// 用来在没有 Windows 的机器上测 ObstacleFinder
+class SyntheticDesktop : public WindowSource
+{
+  public:
+    enum Layout
+    {
+        LAYOUT_TILED,        // 平铺，互不重叠
+        LAYOUT_CASCADED,     // 层叠，每个往右下错开一点
+        LAYOUT_MAXIMIZED,    // 全部最大化 (贴顶，只有最上面那个露出来)
+        LAYOUT_OVERLAPPING,  // 随机大小位置，大面积互相重叠
+        LAYOUT_COUNT
+    };
+
+    static const char *LayoutName(Layout layout);
+
+    // 生成 count 个顶层窗口 (含隐藏的、最小化的和桌面自己的窗口，
+    // 比例大致和真实桌面差不多)，再加一条 40 像素高的任务栏
+    void Generate(Layout   layout,
+                  int      count,
+                  int      screenWidth,
+                  int      screenHeight,
+                  unsigned seed);
+
+    // 模拟用户动一下桌面 (长时间测试用)：挪窗口、置顶、关掉、新开、
+    // 最小化 / 还原，每次随机做一样。窗口的 id 不变，新开的用新 id，
+    // 和真正的 HWND 一样；开和关会把窗口数拉回 Generate 时的数量附近
+    void Churn();
+
+    // 普通窗口的圆角半径 (像 Win11 那样)，0 = 直角 (默认)
+    void SetCornerRadius(int radius) { m_cornerRadius = radius; }
+
+    // 上一次 ResetQueries 之后，查了多少次窗口的情况
+    // (真正的桌面上每一次都是一次系统调用)
+    // 其中多少次是问 DWM 的边框 (最贵的那种)
+    size_t Queries() const { return m_queries; }
+    size_t FrameQueries() const { return m_frameQueries; }
+    void   ResetQueries()
+    {
+        m_queries      = 0;
+        m_frameQueries = 0;
+    }
+
+    // --- WindowSource ---
+    bool GetTaskbar(RECT &rc) override;
+    void Enumerate(WindowVisitor visit, void *ctx) override;
+    bool IsVisible(WindowId window) override;
+    bool IsMinimized(WindowId window) override;
+    void GetClass(WindowId window, wchar_t *name, int size) override;
+    void GetFrame(WindowId window, RECT &rc) override;
+    void GetBounds(WindowId window, RECT &rc) override;
+    bool GetTopMask(WindowId               window,
+                    const RECT            &frame,
+                    std::vector<uint64_t> &bits) override;
+
+  private:
+    struct Window
+    {
+        RECT           frame;
+        bool           visible;
+        bool           minimized;
+        const wchar_t *className;
+        WindowId       id;
+    };
+
+    void Add(const RECT    &frame,
+             bool           visible,
+             bool           minimized,
+             const wchar_t *cls);
+    void Reindex();
+
+    Window &At(WindowId window) { return m_windows[m_position[window]]; }
+
+    std::vector<Window> m_windows;  // 下标 0 在最上面
+
+    // id -> 在 m_windows 里的下标 (窗口的顺序变了就重建)
+    std::unordered_map<WindowId, size_t> m_position;
+    WindowId                             m_nextId = 0;
+
+    RECT                m_taskbar = {0, 0, 0, 0};
+    size_t              m_queries      = 0;
+    size_t              m_frameQueries = 0;
+    int                 m_cornerRadius = 0;
+
+    // Churn 用：随机数、屏幕的大小、Generate 时有几个应用窗口
+    std::mt19937 m_rng;
+    int          m_screenWidth = 0;
+    int          m_workHeight  = 0;
+    size_t       m_apps        = 0;
+};
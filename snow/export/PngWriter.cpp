@@ -0,0 +1,297 @@
+#include "PngWriter.h"
+#include <cstdio>
+#include <cstring>
+
+// ---------------------------------------------------------
+//  deflate 的定长哈夫曼表 (RFC 1951 3.2.6)
+// ---------------------------------------------------------
+
+static const int LENGTH_BASE[29] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
+                                    15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
+                                    67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const int LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                     1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                     4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const int DIST_BASE[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const int DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                   4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                   9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// deflate 的距离最多往回 32768 字节
+static const size_t MAX_DISTANCE = 32768;
+static const int    MAX_MATCH    = 258;
+
+// 哈夫曼码是高位在前的，而比特流是低位在前的，写之前要倒过来
+static uint32_t ReverseBits(uint32_t code, int length)
+{
+    uint32_t out = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        out  = (out << 1) | (code & 1);
+        code >>= 1;
+    }
+    return out;
+}
+
+struct FixedCodes
+{
+    uint16_t code[288];
+    uint8_t  length[288];
+
+    FixedCodes()
+    {
+        // 四段：每段的第一个符号用的码、码长
+        static const int FIRST[4]  = {0, 144, 256, 280};
+        static const int BASE[4]   = {0x30, 0x190, 0x00, 0xC0};
+        static const int LENGTH[4] = {8, 9, 7, 8};
+
+        for (int s = 0; s < 288; ++s)
+        {
+            int r = s < 144 ? 0 : s < 256 ? 1 : s < 280 ? 2 : 3;
+            int len = LENGTH[r];
+            int base = BASE[r] + (s - FIRST[r]);
+            code[s]   = (uint16_t)ReverseBits(base, len);
+            length[s] = (uint8_t)len;
+        }
+    }
+};
+
+static const FixedCodes s_fixed;
+
+// ---------------------------------------------------------
+//  校验和
+// ---------------------------------------------------------
+
+struct CrcTable
+{
+    uint32_t entry[256];
+
+    CrcTable()
+    {
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entry[n] = c;
+        }
+    }
+};
+
+static const CrcTable s_crc;
+
+static uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = s_crc.entry[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t Adler32(const uint8_t *data, size_t size)
+{
+    uint32_t a = 1, b = 0;
+    while (size > 0)
+    {
+        // 5552 是保证 32 位不溢出的最大块长
+        size_t n = size < 5552 ? size : 5552;
+        size -= n;
+        while (n--)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void PutBigEndian(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static bool WriteChunk(FILE          *fp,
+                       const char    *type,
+                       const uint8_t *data,
+                       size_t         size)
+{
+    uint8_t head[8];
+    PutBigEndian(head, (uint32_t)size);
+    memcpy(head + 4, type, 4);
+
+    uint32_t crc = Crc32(0, head + 4, 4);
+    crc          = Crc32(crc, data, size);
+
+    uint8_t tail[4];
+    PutBigEndian(tail, crc);
+
+    return fwrite(head, 1, 8, fp) == 8 &&
+           (size == 0 || fwrite(data, 1, size, fp) == size) &&
+           fwrite(tail, 1, 4, fp) == 4;
+}
+
+// ---------------------------------------------------------
+//  压缩
+// ---------------------------------------------------------
+
+void PngWriter::PutBits(uint32_t bits, int count)
+{
+    m_bitBuffer |= (uint64_t)bits << m_bitCount;
+    m_bitCount += count;
+    while (m_bitCount >= 8)
+    {
+        m_out.push_back((uint8_t)m_bitBuffer);
+        m_bitBuffer >>= 8;
+        m_bitCount -= 8;
+    }
+}
+
+void PngWriter::PutCode(int symbol)
+{
+    PutBits(s_fixed.code[symbol], s_fixed.length[symbol]);
+}
+
+void PngWriter::PutMatch(int length, int distance)
+{
+    int l = 28;
+    while (LENGTH_BASE[l] > length)
+        --l;
+    PutCode(257 + l);
+    PutBits(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+    // 距离码是定长 5 位
+    int d = 29;
+    while (DIST_BASE[d] > distance)
+        --d;
+    PutBits(ReverseBits(d, 5), 5);
+    PutBits(distance - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+void PngWriter::FlushBits()
+{
+    if (m_bitCount > 0)
+        m_out.push_back((uint8_t)m_bitBuffer);
+    m_bitBuffer = 0;
+    m_bitCount  = 0;
+}
+
+// 贪心：每个位置看“往回 4 字节” (前一个像素) 和“往回一行”哪个重复得更长
+void PngWriter::Deflate(const uint8_t *data, size_t size, size_t stride)
+{
+    m_out.clear();
+    m_bitBuffer = 0;
+    m_bitCount  = 0;
+
+    // zlib 头：deflate，32K 窗口，不带字典
+    m_out.push_back(0x78);
+    m_out.push_back(0x01);
+
+    // 整个就一个定长哈夫曼块 (BFINAL = 1, BTYPE = 01)
+    PutBits(1, 1);
+    PutBits(1, 2);
+
+    const size_t distances[2] = {4, stride <= MAX_DISTANCE ? stride : 0};
+
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t limit = size - i < MAX_MATCH ? size - i : MAX_MATCH;
+
+        size_t bestLen  = 0;
+        size_t bestDist = 0;
+        for (size_t dist : distances)
+        {
+            if (dist == 0 || i < dist)
+                continue;
+            const uint8_t *a   = data + i;
+            const uint8_t *b   = a - dist;
+            size_t         len = 0;
+
+            // 大片空白一次比 8 个字节
+            uint64_t wa, wb;
+            while (len + 8 <= limit)
+            {
+                memcpy(&wa, a + len, 8);
+                memcpy(&wb, b + len, 8);
+                if (wa != wb)
+                    break;
+                len += 8;
+            }
+            while (len < limit && a[len] == b[len])
+                ++len;
+            if (len > bestLen)
+            {
+                bestLen  = len;
+                bestDist = dist;
+            }
+        }
+
+        if (bestLen >= 3)
+        {
+            PutMatch((int)bestLen, (int)bestDist);
+            i += bestLen;
+        }
+        else
+        {
+            PutCode(data[i]);
+            ++i;
+        }
+    }
+
+    PutCode(256);  // 块结束
+    FlushBits();
+
+    uint8_t adler[4];
+    PutBigEndian(adler, Adler32(data, size));
+    m_out.insert(m_out.end(), adler, adler + 4);
+}
+
+bool PngWriter::Write(const char    *path,
+                      const uint8_t *rgba,
+                      int            width,
+                      int            height)
+{
+    // 每行前面一个过滤字节，不过滤 (“往回一行”的匹配已经起到了 Up 过滤的作用)
+    size_t rowBytes = (size_t)width * 4;
+    size_t stride   = rowBytes + 1;
+    m_raw.resize(stride * height);
+    for (int y = 0; y < height; ++y)
+    {
+        m_raw[stride * y] = 0;
+        memcpy(&m_raw[stride * y + 1], rgba + rowBytes * y, rowBytes);
+    }
+
+    Deflate(m_raw.data(), m_raw.size(), stride);
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+        return false;
+
+    static const uint8_t SIGNATURE[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    // IHDR：宽、高、8 位、RGBA、deflate、标准过滤、不隔行
+    uint8_t ihdr[13];
+    PutBigEndian(ihdr, (uint32_t)width);
+    PutBigEndian(ihdr + 4, (uint32_t)height);
+    ihdr[8]  = 8;
+    ihdr[9]  = 6;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+
+    bool ok = fwrite(SIGNATURE, 1, 8, fp) == 8 &&
+              WriteChunk(fp, "IHDR", ihdr, sizeof(ihdr)) &&
+              WriteChunk(fp, "IDAT", m_out.data(), m_out.size()) &&
+              WriteChunk(fp, "IEND", nullptr, 0);
+
+    return fclose(fp) == 0 && ok;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// 把一帧 RGBA 写成 PNG 文件，不依赖 zlib
+// 压缩是自己写的定长哈夫曼 deflate，只找两种重复：
+// 和前一个像素一样、和上一行一样
+// 雪景大片是透明 (或者纯色背景)，这两种就能压掉绝大部分
+// 每个线程用自己的 PngWriter (里面的缓冲留着复用)
+class PngWriter
+{
+  public:
+    bool Write(const char *path, const uint8_t *rgba, int width, int height);
+
+  private:
+    void Deflate(const uint8_t *data, size_t size, size_t stride);
+
+    void PutBits(uint32_t bits, int count);
+    void PutCode(int symbol);
+    void PutMatch(int length, int distance);
+    void FlushBits();
+
+    std::vector<uint8_t> m_raw;  // 每行前面加一个过滤字节 (0 = 不过滤)
+    std::vector<uint8_t> m_out;  // zlib 流
+
+    uint64_t m_bitBuffer = 0;
+    int      m_bitCount  = 0;
+};
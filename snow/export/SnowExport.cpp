@@ -0,0 +1,642 @@
+// 离线导出：不开窗口，用固定的种子和步长跑 SnowEngine，在 CPU 上画出每一帧，
+// 写成原始 RGBA、Y4M 视频流或者 PNG 序列 (做循环的视频、动态壁纸用)
+//
+// 三段流水线同时在跑，互相之间用有界的队列连着：
+//   模拟 (主线程) -> 按带子分给 N 个画图线程 -> 写出 (PNG 由画完最后一条带子的
+//   线程直接压缩写文件；视频流由一个写线程按顺序拼起来)
+// 同时在路上的帧数固定 (帧池)，模拟跑得再快也只会等，不会把内存吃光
+//
+// 不依赖 Windows，Linux 上这样编译：
+//   g++ -O2 -std=c++17 -pthread -I../src -o snow_export
+//       SnowExport.cpp SoftRaster.cpp PngWriter.cpp ../src/SnowEngine.cpp
+//       ../src/WindField.cpp ../src/FlakeGrid.cpp ../src/CompactFlake.cpp
+//       ../src/SurfaceEdges.cpp ../src/ObstacleDiff.cpp ../src/StateFile.cpp
+//   (写在一行里)
+// 用法：snow_export [选项] 输出
+//   输出是文件名；raw / y4m 可以用 - 表示标准输出 (直接接 ffmpeg)，
+//   png 是文件名前缀，会写成 前缀00000.png、前缀00001.png ……
+//   --format=raw|y4m|png  (默认 y4m)
+//   --width=W --height=H  (默认 3840x2160)
+//   --frames=N            输出多少帧 (默认 300，模拟一步 = 一帧 = 1/30 秒)
+//   --loop=F              最后 F 帧和开头交叉淡化，首尾接上无缝循环 (默认 0)
+//   --warmup=N            开始输出前先空跑几步，让雪铺满整个画面 (默认 300)
+//   --seed=S --count=C --gravity=G --wind=W --turbulence=T
+//   --compact             用紧凑存储 (几万片以上时)
+//   --background=RRGGBB   铺一层不透明的背景；不给的话 raw / png 是透明的，
+//                         y4m 没有透明通道，垫黑色
+//   --threads=N           画图线程数 (默认 CPU 核数)
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SnowEngine.h"
+#include "SoftRaster.h"
+#include "PngWriter.h"
+
+// 引擎里鼠标互动的开关在 Main.cpp 里，导出时没有鼠标
+bool g_bEnableMouseInteraction = false;
+
+// 模拟一步的时长 (FramePacer 的 33.3 毫秒)，输出的帧率就是它
+static const int FRAME_RATE = 30;
+
+enum class ExportFormat
+{
+    Raw,
+    Y4m,
+    Png
+};
+
+struct ExportOptions
+{
+    ExportFormat format = ExportFormat::Y4m;
+    std::string  output;
+
+    int width  = 3840;
+    int height = 2160;
+    int frames = 300;
+    int loop   = 0;
+    int warmup = 300;
+
+    uint32_t seed       = 1;
+    int      count      = 1000;
+    float    gravity    = 1.0f;
+    float    wind       = 0.0f;
+    float    turbulence = 0.0f;
+    bool     compact    = false;
+
+    bool    opaque = false;
+    uint8_t background[3] = {0, 0, 0};
+
+    int threads = 0;
+};
+
+// ---------------------------------------------------------
+//  线程之间传东西用的阻塞队列
+// ---------------------------------------------------------
+
+template <typename T>
+class BlockingQueue
+{
+  public:
+    void Push(const T &item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_items.push_back(item);
+        }
+        m_cond.notify_one();
+    }
+
+    // 取不到就等；Close 以后取空了返回 false
+    bool Pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] { return !m_items.empty() || m_bClosed; });
+        if (m_items.empty())
+            return false;
+        item = m_items.front();
+        m_items.pop_front();
+        return true;
+    }
+
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bClosed = true;
+        }
+        m_cond.notify_all();
+    }
+
+  private:
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    std::deque<T>           m_items;
+    bool                    m_bClosed = false;
+};
+
+// ---------------------------------------------------------
+//  流水线上的一帧
+// ---------------------------------------------------------
+
+struct ExportFrame
+{
+    uint64_t index = 0;  // 输出的第几帧
+
+    // [0] 是这一帧，[1] 是交叉淡化时要混进来的开头那一帧
+    std::vector<SnowStamp>             stamps[2];
+    std::vector<std::vector<uint32_t>> bins[2];
+    float                              fade = 0.0f;  // [1] 占多少 (0 = 不混)
+
+    // 输出格式的一帧 (各条带子各写各的那一段)
+    std::vector<uint8_t> pixels;
+
+    std::atomic<int> bandsLeft{0};
+};
+
+struct BandJob
+{
+    ExportFrame *frame;
+    int          band;
+};
+
+// ---------------------------------------------------------
+//  覆盖率 -> 输出格式
+// ---------------------------------------------------------
+
+// 雪是白的，合成出来的颜色只取决于覆盖率：覆盖率量化成 256 档，
+// 每一档的输出 (RGBA / Y / Cb / Cr) 事先算好，转换时只查表
+struct PixelTable
+{
+    uint8_t rgba[256][4];
+    uint8_t y[256];
+    int     cb[256];  // 乘了 16，四个加起来除以 64 就是 2x2 的平均
+    int     cr[256];
+
+    void Build(const ExportOptions &opt)
+    {
+        for (int q = 0; q < 256; ++q)
+        {
+            // 白雪盖在背景上：c = bg + (255 - bg) * 覆盖率
+            float cov = q / 255.0f;
+            float rgb[3];
+            for (int ch = 0; ch < 3; ++ch)
+            {
+                float bg = opt.background[ch];
+                rgb[ch]  = bg + (255.0f - bg) * cov;
+            }
+
+            if (opt.opaque)
+            {
+                for (int ch = 0; ch < 3; ++ch)
+                    rgba[q][ch] = (uint8_t)(rgb[ch] + 0.5f);
+                rgba[q][3] = 255;
+            }
+            else
+            {
+                // 不预乘：颜色一直是白的，深浅全在 alpha 里
+                rgba[q][0] = rgba[q][1] = rgba[q][2] = 255;
+                rgba[q][3]                           = (uint8_t)q;
+            }
+
+            // BT.601 有限范围
+            float yy = 16.0f + 0.2568f * rgb[0] + 0.5041f * rgb[1] +
+                       0.0979f * rgb[2];
+            float u = 128.0f - 0.1482f * rgb[0] - 0.2910f * rgb[1] +
+                      0.4392f * rgb[2];
+            float v = 128.0f + 0.4392f * rgb[0] - 0.3678f * rgb[1] -
+                      0.0714f * rgb[2];
+            y[q]  = (uint8_t)(yy + 0.5f);
+            cb[q] = (int)(u * 16.0f + 0.5f);
+            cr[q] = (int)(v * 16.0f + 0.5f);
+        }
+    }
+};
+
+static inline int Quantize(float coverage)
+{
+    return coverage >= 1.0f ? 255 : (int)(coverage * 255.0f + 0.5f);
+}
+
+static void ToRgba(const PixelTable &table,
+                   const float      *coverage,
+                   int               pixels,
+                   uint8_t          *out)
+{
+    for (int i = 0; i < pixels; ++i, out += 4)
+        memcpy(out, table.rgba[Quantize(coverage[i])], 4);
+}
+
+// 4:2:0：Y 每个像素一个，Cb / Cr 每 2x2 一个 (取平均)
+// 带子的行数是偶数，第 band 条带子的色度正好是色度平面里的第 y0/2 行起
+static void ToYuv420(const PixelTable &table,
+                     const float      *coverage,
+                     int               width,
+                     int               height,
+                     int               y0,
+                     int               rows,
+                     uint8_t          *frame)
+{
+    uint8_t *planeY  = frame;
+    uint8_t *planeCb = planeY + (size_t)width * height;
+    uint8_t *planeCr = planeCb + (size_t)(width / 2) * (height / 2);
+
+    for (int y = 0; y < rows; y += 2)
+    {
+        const float *row0 = coverage + (size_t)y * width;
+        const float *row1 = row0 + width;
+        uint8_t     *outY = planeY + (size_t)(y0 + y) * width;
+        size_t       c    = (size_t)((y0 + y) / 2) * (width / 2);
+
+        for (int x = 0; x < width; x += 2)
+        {
+            int q[4] = {Quantize(row0[x]),
+                        Quantize(row0[x + 1]),
+                        Quantize(row1[x]),
+                        Quantize(row1[x + 1])};
+
+            outY[x]             = table.y[q[0]];
+            outY[x + 1]         = table.y[q[1]];
+            outY[width + x]     = table.y[q[2]];
+            outY[width + x + 1] = table.y[q[3]];
+
+            int sumCb = table.cb[q[0]] + table.cb[q[1]] + table.cb[q[2]] +
+                        table.cb[q[3]];
+            int sumCr = table.cr[q[0]] + table.cr[q[1]] + table.cr[q[2]] +
+                        table.cr[q[3]];
+            planeCb[c + x / 2] = (uint8_t)((sumCb + 32) >> 6);
+            planeCr[c + x / 2] = (uint8_t)((sumCr + 32) >> 6);
+        }
+    }
+}
+
+static size_t FrameBytes(const ExportOptions &opt)
+{
+    size_t pixels = (size_t)opt.width * opt.height;
+    return opt.format == ExportFormat::Y4m ? pixels + pixels / 2 : pixels * 4;
+}
+
+// ---------------------------------------------------------
+//  流水线
+// ---------------------------------------------------------
+
+class ExportPipeline
+{
+  public:
+    explicit ExportPipeline(const ExportOptions &opt) : m_opt(opt)
+    {
+        m_raster.Resize(opt.width, opt.height);
+        m_table.Build(opt);
+    }
+
+    bool Run();
+
+  private:
+    void RasterThread();
+    void WriterThread();
+    void RenderBand(const BandJob &job, float *cov0, float *cov1);
+    void FinishFrame(ExportFrame *frame, PngWriter &png);
+    void Fail(const char *message);
+
+    const ExportOptions &m_opt;
+    SoftRaster           m_raster;
+    PixelTable           m_table;
+
+    BlockingQueue<ExportFrame *> m_free;  // 空闲的帧 (帧池)
+    BlockingQueue<BandJob>       m_jobs;  // 等着画的带子
+    BlockingQueue<ExportFrame *> m_done;  // 画完了等着按顺序写的帧 (视频流)
+
+    FILE             *m_stream = nullptr;
+    std::atomic<bool> m_bFailed{false};
+};
+
+void ExportPipeline::Fail(const char *message)
+{
+    if (!m_bFailed.exchange(true))
+        fprintf(stderr, "snow_export: %s\n", message);
+}
+
+void ExportPipeline::RenderBand(const BandJob &job, float *cov0, float *cov1)
+{
+    ExportFrame *frame = job.frame;
+    int          band  = job.band;
+    int          rows  = m_raster.BandRows(band);
+    int          n     = m_opt.width * rows;
+
+    m_raster.DrawBand(band, frame->stamps[0], frame->bins[0][band], cov0);
+
+    // 交叉淡化：两帧各画一遍再按比例混 (混的是画好的图，不是雪花)
+    if (frame->fade > 0.0f)
+    {
+        m_raster.DrawBand(band, frame->stamps[1], frame->bins[1][band], cov1);
+        float f = frame->fade;
+        for (int i = 0; i < n; ++i)
+            cov0[i] += (cov1[i] - cov0[i]) * f;
+    }
+
+    int y0 = band * SoftRaster::BAND_ROWS;
+    if (m_opt.format == ExportFormat::Y4m)
+    {
+        ToYuv420(m_table,
+                 cov0,
+                 m_opt.width,
+                 m_opt.height,
+                 y0,
+                 rows,
+                 frame->pixels.data());
+    }
+    else
+    {
+        ToRgba(m_table,
+               cov0,
+               n,
+               frame->pixels.data() + (size_t)y0 * m_opt.width * 4);
+    }
+}
+
+void ExportPipeline::FinishFrame(ExportFrame *frame, PngWriter &png)
+{
+    if (m_opt.format != ExportFormat::Png)
+    {
+        m_done.Push(frame);
+        return;
+    }
+
+    // PNG 一帧一个文件，谁画完最后一条带子谁压缩，不用排队
+    char path[1024];
+    snprintf(path,
+             sizeof(path),
+             "%s%05llu.png",
+             m_opt.output.c_str(),
+             (unsigned long long)frame->index);
+    if (!m_bFailed && !png.Write(path,
+                                 frame->pixels.data(),
+                                 m_opt.width,
+                                 m_opt.height))
+        Fail("cannot write PNG");
+    m_free.Push(frame);
+}
+
+void ExportPipeline::RasterThread()
+{
+    size_t             band = (size_t)m_opt.width * SoftRaster::BAND_ROWS;
+    std::vector<float> cov0(band), cov1(band);
+    PngWriter          png;
+
+    BandJob job;
+    while (m_jobs.Pop(job))
+    {
+        RenderBand(job, cov0.data(), cov1.data());
+
+        // 最后一条带子画完的线程负责把这一帧往下交
+        if (job.frame->bandsLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            FinishFrame(job.frame, png);
+    }
+}
+
+// 画完的顺序不一定，这里攒着，按帧号一帧帧写出去
+void ExportPipeline::WriterThread()
+{
+    std::map<uint64_t, ExportFrame *> pending;
+    uint64_t                          next = 0;
+    size_t                            size = FrameBytes(m_opt);
+
+    ExportFrame *frame;
+    while (m_done.Pop(frame))
+    {
+        pending[frame->index] = frame;
+        for (auto it = pending.find(next); it != pending.end();
+             it      = pending.find(next))
+        {
+            ExportFrame *ready = it->second;
+            pending.erase(it);
+            ++next;
+
+            if (!m_bFailed)
+            {
+                const uint8_t *data = ready->pixels.data();
+                bool           ok   = true;
+                if (m_opt.format == ExportFormat::Y4m)
+                    ok = fputs("FRAME\n", m_stream) >= 0;
+                if (ok)
+                    ok = fwrite(data, 1, size, m_stream) == size;
+                if (!ok)
+                    Fail("cannot write output");
+            }
+            m_free.Push(ready);
+        }
+    }
+}
+
+bool ExportPipeline::Run()
+{
+    const ExportOptions &opt = m_opt;
+
+    if (opt.format != ExportFormat::Png)
+    {
+        m_stream = opt.output == "-" ? stdout : fopen(opt.output.c_str(), "wb");
+        if (!m_stream)
+        {
+            Fail("cannot open output");
+            return false;
+        }
+        if (opt.format == ExportFormat::Y4m)
+        {
+            fprintf(m_stream,
+                    "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                    opt.width,
+                    opt.height,
+                    FRAME_RATE);
+        }
+    }
+
+    int threads = opt.threads;
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 4;
+
+    // 帧池：每个画图线程手上一帧 (PNG 压缩也在它们手上)，再多两帧给模拟和写出
+    std::vector<ExportFrame> pool(threads + 2);
+    for (auto &frame : pool)
+    {
+        frame.pixels.resize(FrameBytes(opt));
+        m_free.Push(&frame);
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back(&ExportPipeline::RasterThread, this);
+    std::thread writer;
+    if (opt.format != ExportFormat::Png)
+        writer = std::thread(&ExportPipeline::WriterThread, this);
+
+    SnowEngine engine(opt.seed);
+    engine.SetCompactStorage(opt.compact);
+    engine.SetGravity(opt.gravity);
+    engine.SetWind(opt.wind);
+    engine.SetTurbulence(opt.turbulence);
+    engine.Initialize(opt.width, opt.height, opt.count);
+
+    // 没有窗口也没有鼠标：雪直接落出屏幕底边
+    const std::vector<Obstacle> obstacles;
+    const std::vector<POINT>    mousePath;
+    SnowSnapshot                snapshot;
+
+    // 交叉淡化：开头 F 帧先只记下来不输出，最后 F 帧输出时混进去，
+    // 第 i 帧 = 模拟的第 frames+i 帧 × (1 - i/F) + 第 i 帧 × i/F
+    // 输出从第 F 帧开始，最后接回第 0..F-1 帧 —— 转了一圈，首尾正好接上
+    std::vector<std::vector<SnowStamp>> head(opt.loop);
+
+    auto     start    = std::chrono::steady_clock::now();
+    int      total    = opt.frames + opt.loop;
+    uint64_t outIndex = 0;
+    for (int step = -opt.warmup; step < total && !m_bFailed; ++step)
+    {
+        engine.Update(opt.width, opt.height, obstacles, mousePath);
+        if (step < 0)
+            continue;
+
+        engine.BuildSnapshot(snapshot);
+        if (step < opt.loop)
+        {
+            SoftRaster::Collect(snapshot, head[step]);
+            continue;
+        }
+
+        ExportFrame *frame = nullptr;
+        if (!m_free.Pop(frame))
+            break;
+        frame->index = outIndex++;
+        SoftRaster::Collect(snapshot, frame->stamps[0]);
+        m_raster.Bin(frame->stamps[0], frame->bins[0]);
+
+        frame->fade = 0.0f;
+        if (step >= opt.frames)
+        {
+            int i       = step - opt.frames;
+            frame->fade = (float)i / opt.loop;
+            frame->stamps[1].swap(head[i]);
+            m_raster.Bin(frame->stamps[1], frame->bins[1]);
+        }
+
+        int bands = m_raster.BandCount();
+        frame->bandsLeft.store(bands, std::memory_order_relaxed);
+        for (int b = 0; b < bands; ++b)
+            m_jobs.Push({frame, b});
+    }
+
+    m_jobs.Close();
+    for (auto &t : workers)
+        t.join();
+    m_done.Close();
+    if (writer.joinable())
+        writer.join();
+
+    if (m_stream && m_stream != stdout && fclose(m_stream) != 0)
+        Fail("cannot write output");
+    else if (m_stream == stdout)
+        fflush(stdout);
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    fprintf(stderr,
+            "%llu frames %dx%d, %.2f s, %.1f fps (%.1fx real time), "
+            "%d raster threads\n",
+            (unsigned long long)outIndex,
+            opt.width,
+            opt.height,
+            seconds,
+            outIndex / seconds,
+            outIndex / seconds / FRAME_RATE,
+            threads);
+
+    return !m_bFailed;
+}
+
+// ---------------------------------------------------------
+//  命令行
+// ---------------------------------------------------------
+
+// "--name=value" 里名字对上了就返回 value，否则返回 nullptr
+static const char *OptionValue(const char *arg, const char *name)
+{
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) != 0 || arg[n] != '=')
+        return nullptr;
+    return arg + n + 1;
+}
+
+static bool ParseOptions(int argc, char **argv, ExportOptions &opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *v;
+
+        if ((v = OptionValue(arg, "--format")))
+        {
+            if (strcmp(v, "raw") == 0)
+                opt.format = ExportFormat::Raw;
+            else if (strcmp(v, "y4m") == 0)
+                opt.format = ExportFormat::Y4m;
+            else if (strcmp(v, "png") == 0)
+                opt.format = ExportFormat::Png;
+            else
+                return false;
+        }
+        else if ((v = OptionValue(arg, "--width")))
+            opt.width = atoi(v);
+        else if ((v = OptionValue(arg, "--height")))
+            opt.height = atoi(v);
+        else if ((v = OptionValue(arg, "--frames")))
+            opt.frames = atoi(v);
+        else if ((v = OptionValue(arg, "--loop")))
+            opt.loop = atoi(v);
+        else if ((v = OptionValue(arg, "--warmup")))
+            opt.warmup = atoi(v);
+        else if ((v = OptionValue(arg, "--seed")))
+            opt.seed = (uint32_t)strtoul(v, nullptr, 10);
+        else if ((v = OptionValue(arg, "--count")))
+            opt.count = atoi(v);
+        else if ((v = OptionValue(arg, "--gravity")))
+            opt.gravity = (float)atof(v);
+        else if ((v = OptionValue(arg, "--wind")))
+            opt.wind = (float)atof(v);
+        else if ((v = OptionValue(arg, "--turbulence")))
+            opt.turbulence = (float)atof(v);
+        else if ((v = OptionValue(arg, "--threads")))
+            opt.threads = atoi(v);
+        else if ((v = OptionValue(arg, "--background")))
+        {
+            unsigned long rgb   = strtoul(v, nullptr, 16);
+            opt.background[0] = (uint8_t)(rgb >> 16);
+            opt.background[1] = (uint8_t)(rgb >> 8);
+            opt.background[2] = (uint8_t)rgb;
+            opt.opaque        = true;
+        }
+        else if (strcmp(arg, "--compact") == 0)
+            opt.compact = true;
+        else if (arg[0] == '-' && arg[1] == '-')
+            return false;
+        else
+            opt.output = arg;
+    }
+
+    if (opt.output.empty() || opt.width <= 0 || opt.height <= 0 ||
+        opt.frames <= 0 || opt.loop < 0 || opt.loop >= opt.frames ||
+        opt.warmup < 0 || opt.count < 0)
+        return false;
+
+    // 4:2:0 的色度是 2x2 一个，长宽都得是偶数
+    if (opt.format == ExportFormat::Y4m && (opt.width % 2 || opt.height % 2))
+        return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    ExportOptions opt;
+    if (!ParseOptions(argc, argv, opt))
+    {
+        fprintf(stderr,
+                "usage: snow_export [--format=raw|y4m|png] [--width=W] "
+                "[--height=H] [--frames=N] [--loop=F] [--warmup=N] "
+                "[--seed=S] [--count=C] [--gravity=G] [--wind=W] "
+                "[--turbulence=T] [--compact] [--background=RRGGBB] "
+                "[--threads=N] output\n");
+        return 2;
+    }
+
+    ExportPipeline pipeline(opt);
+    return pipeline.Run() ? 0 : 1;
+}
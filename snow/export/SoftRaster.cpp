@@ -0,0 +1,110 @@
+#include "SoftRaster.h"
+#include <cmath>
+#include <cstring>
+
+SoftRaster::SoftRaster()
+{
+    // SnowPresenter 的印章是中心白、边缘透的径向渐变，透明度随半径线性下降
+    for (int i = 0; i <= PROFILE_SIZE; ++i)
+        m_profile[i] = 1.0f - sqrtf((float)i / PROFILE_SIZE);
+}
+
+void SoftRaster::Resize(int width, int height)
+{
+    m_width  = width;
+    m_height = height;
+}
+
+void SoftRaster::Collect(const SnowSnapshot   &snapshot,
+                         std::vector<SnowStamp> &stamps)
+{
+    stamps.clear();
+    stamps.reserve(snapshot.sprites.size() + snapshot.landed.size());
+
+    // SnowPresenter 画的矩形是中心 ± size，所以 size 就是半径
+    for (const auto &sp : snapshot.sprites)
+        stamps.push_back({sp.x, sp.y, sp.size, sp.opacity});
+    for (const auto &landed : snapshot.landed)
+    {
+        const FlakeSprite &sp = landed.sprite;
+        stamps.push_back({sp.x, sp.y, sp.size, sp.opacity});
+    }
+}
+
+void SoftRaster::Bin(const std::vector<SnowStamp>      &stamps,
+                     std::vector<std::vector<uint32_t>> &bins) const
+{
+    int bands = BandCount();
+    bins.resize(bands);
+    for (auto &bin : bins)
+        bin.clear();
+
+    for (size_t i = 0; i < stamps.size(); ++i)
+    {
+        const SnowStamp &s = stamps[i];
+        if (s.opacity <= 0.0f || s.radius <= 0.0f ||
+            s.x + s.radius < 0.0f || s.x - s.radius > (float)m_width)
+            continue;
+
+        // 一颗雪花最多十几像素高，一般只落在一两条带子里
+        int first = (int)floorf((s.y - s.radius) / BAND_ROWS);
+        int last  = (int)floorf((s.y + s.radius) / BAND_ROWS);
+        if (first < 0)
+            first = 0;
+        if (last >= bands)
+            last = bands - 1;
+        for (int b = first; b <= last; ++b)
+            bins[b].push_back((uint32_t)i);
+    }
+}
+
+void SoftRaster::DrawBand(int                           band,
+                          const std::vector<SnowStamp> &stamps,
+                          const std::vector<uint32_t>  &bin,
+                          float                        *coverage) const
+{
+    int y0   = band * BAND_ROWS;
+    int rows = BandRows(band);
+    memset(coverage, 0, sizeof(float) * m_width * rows);
+
+    for (uint32_t index : bin)
+    {
+        const SnowStamp &s = stamps[index];
+
+        // 只看像素中心落在圆里的那些像素 (中心在 +0.5 处)
+        int top    = (int)floorf(s.y - s.radius);
+        int bottom = (int)ceilf(s.y + s.radius);
+        int left   = (int)floorf(s.x - s.radius);
+        int right  = (int)ceilf(s.x + s.radius);
+        if (top < y0)
+            top = y0;
+        if (bottom > y0 + rows - 1)
+            bottom = y0 + rows - 1;
+        if (left < 0)
+            left = 0;
+        if (right > m_width - 1)
+            right = m_width - 1;
+
+        float invR2 = 1.0f / (s.radius * s.radius);
+        for (int py = top; py <= bottom; ++py)
+        {
+            float dy  = (float)py + 0.5f - s.y;
+            float dy2 = dy * dy * invR2;
+            if (dy2 >= 1.0f)
+                continue;
+
+            float *row = coverage + (size_t)(py - y0) * m_width;
+            for (int px = left; px <= right; ++px)
+            {
+                float dx = (float)px + 0.5f - s.x;
+                float t  = dx * dx * invR2 + dy2;
+                if (t >= 1.0f)
+                    continue;
+
+                // 叠加 (source-over)：已经盖住的部分不再变白
+                float a = s.opacity * m_profile[(int)(t * PROFILE_SIZE)];
+                row[px] += a * (1.0f - row[px]);
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "SnowSnapshot.h"
+
+// 离线导出用的 CPU 画雪 (不碰 Direct2D)
+// 雪花都是白的，所以每个像素只记一个覆盖率 (0..1)，最后再按输出格式合成到背景上
+// 画面横着切成一条条 BAND_ROWS 行高的带子，带子之间互不相干，
+// 可以分给不同的线程画
+
+// 一个要盖的印章：中心、半径、透明度 (和 SnowPresenter 里 DrawBitmap 的一样)
+struct SnowStamp
+{
+    float x;
+    float y;
+    float radius;
+    float opacity;
+};
+
+class SoftRaster
+{
+  public:
+    static const int BAND_ROWS = 64;
+
+    SoftRaster();
+
+    void Resize(int width, int height);
+
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+    int BandCount() const { return (m_height + BAND_ROWS - 1) / BAND_ROWS; }
+
+    // 第 band 条带子有几行 (最后一条可能不满)
+    int BandRows(int band) const
+    {
+        int rows = m_height - band * BAND_ROWS;
+        return rows < BAND_ROWS ? rows : BAND_ROWS;
+    }
+
+    // 快照里要画的 (下落的 + 堆积的) 都变成印章
+    // 白色叠白色的覆盖率和先后顺序无关，所以不用管谁在上面
+    static void Collect(const SnowSnapshot   &snapshot,
+                        std::vector<SnowStamp> &stamps);
+
+    // 按带子分组：bins[b] 是和第 b 条带子相交的印章下标 (容量留着复用)
+    void Bin(const std::vector<SnowStamp>      &stamps,
+             std::vector<std::vector<uint32_t>> &bins) const;
+
+    // 画第 band 条带子：coverage 是 Width() * BandRows(band) 个覆盖率，
+    // 先清零再盖
+    void DrawBand(int                           band,
+                  const std::vector<SnowStamp> &stamps,
+                  const std::vector<uint32_t>  &bin,
+                  float                        *coverage) const;
+
+  private:
+    int m_width  = 0;
+    int m_height = 0;
+
+    // 径向渐变 (中心不透明，边上全透) 按 (距离 / 半径)^2 查表，
+    // 省掉每个像素一次开方
+    static const int PROFILE_SIZE = 256;
+    float            m_profile[PROFILE_SIZE + 1];
+};
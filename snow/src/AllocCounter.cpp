@@ -0,0 +1,169 @@
+#include "AllocCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>  // _aligned_malloc
+#endif
+
+// 替换全局的 operator new / delete，数一数分配了几次
+// 每一种 new 都要换，不然漏掉的那几种 (nothrow、按对齐的) 就数不到；
+// 每一种 delete 也要换，和自己的 new 配对 (对齐分配的内存要用对齐的方式释放)
+
+static std::atomic<uint64_t> s_allocations{0};
+
+uint64_t AllocCounter::Count()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+// 按标准的要求：分配失败先调 new_handler (它可能腾出内存)，没有才抛 bad_alloc
+static void *Allocate(size_t size)
+{
+    if (size == 0)
+        size = 1;
+
+    for (;;)
+    {
+        void *p = malloc(size);
+        if (p)
+        {
+            s_allocations.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void *AllocateAligned(size_t size, std::align_val_t align)
+{
+    size_t alignment = (size_t)align;
+    if (alignment < sizeof(void *))
+        alignment = sizeof(void *);
+    if (size == 0)
+        size = 1;
+
+    for (;;)
+    {
+#ifdef _WIN32
+        void *p = _aligned_malloc(size, alignment);
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, alignment, size) != 0)
+            p = nullptr;
+#endif
+        if (p)
+        {
+            s_allocations.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void FreeAligned(void *p)
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+// --- 普通 ---
+
+void *operator new(size_t size) { return Allocate(size); }
+void *operator new[](size_t size) { return Allocate(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return Allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
+
+// --- 按对齐分配 (alignas 超过默认对齐的类型) ---
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    return AllocateAligned(size, align);
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+    return AllocateAligned(size, align);
+}
+
+void *operator new(size_t                size,
+                   std::align_val_t      align,
+                   const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return AllocateAligned(size, align);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t                size,
+                     std::align_val_t      align,
+                     const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, align, tag);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { FreeAligned(p); }
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+    FreeAligned(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept
+{
+    FreeAligned(p);
+}
+
+void operator delete(void *p,
+                     std::align_val_t,
+                     const std::nothrow_t &) noexcept
+{
+    FreeAligned(p);
+}
+
+void operator delete[](void *p,
+                       std::align_val_t,
+                       const std::nothrow_t &) noexcept
+{
+    FreeAligned(p);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// 整个进程的堆分配计数 (监控里的 allocations，稳定以后每帧应该是 0)
+//
+// 注意：AllocCounter.cpp 替换了全局的 operator new / delete (所有形式：
+// 普通、数组、nothrow、按对齐分配，以及对应的 delete)，
+// 链接了它的程序里每一次 new 都会经过它，只多一次 relaxed 的原子加
+// 只有主程序链接它；bench/、export/ 下的工具不链接，用的还是标准库自己的
+class AllocCounter
+{
+  public:
+    // 进程启动以来 operator new (所有形式) 成功分配的次数
+    static uint64_t Count();
+};
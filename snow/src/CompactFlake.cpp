@@ -0,0 +1,27 @@
+#include "CompactFlake.h"
+#include <cmath>
+
+float      FlakeCodec::s_sinTable[FlakeCodec::SIN_TABLE_SIZE + 1];
+const bool FlakeCodec::s_sinTableReady = FlakeCodec::BuildSinTable();
+
+// 程序启动时把正弦表填好
+bool FlakeCodec::BuildSinTable()
+{
+    for (int i = 0; i <= SIN_TABLE_SIZE; ++i)
+        s_sinTable[i] = sinf(6.2831853f * i / SIN_TABLE_SIZE);
+    return true;
+}
+
+void FlakeCodec::SetTile(float originX, float originY, float width, float height)
+{
+    m_originX = originX;
+    m_originY = originY;
+    m_width   = width;
+    m_height  = height;
+
+    // 65535 个量化台阶铺满整个 tile
+    m_stepX    = width / 65535.0f;
+    m_stepY    = height / 65535.0f;
+    m_invStepX = 65535.0f / width;
+    m_invStepY = 65535.0f / height;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include "Snowflake.h"
+
+// 紧凑雪花：16 字节 (完整的 Snowflake 是 44 字节)
+// 给十万片级别的“暴风雪”用，工作集能留在缓存里，Update/Render 的内存带宽减半
+struct CompactFlake
+{
+    uint16_t x;          // 定点坐标：相对于 tile 原点，tile 均分成 65536 份
+    uint16_t y;
+    int16_t  vx;         // 速度：1/256 像素/帧
+    int16_t  vy;
+    uint16_t phase;      // 摇摆相位：65536 = 一整圈，溢出就是自然回绕
+    uint8_t  maxSize;    // 原本的大小：1/16 像素
+    uint8_t  sizeScale;  // 当前大小 / 原本大小：1/255 (化了一半又滑落的会小一圈)
+    uint8_t  speed;      // 终端速度：1/32 像素/帧
+    uint8_t  flags;      // bit0 = 已着陆
+    uint16_t eventTick;  // 帧号低 16 位：着陆的雪=着陆帧，下落的雪=下次碰撞检测帧
+};
+
+static_assert(sizeof(CompactFlake) == 16, "CompactFlake 必须是 16 字节");
+
+// 编解码器：完整雪花 <-> 紧凑雪花
+// 解码/编码都是几条乘法，直接融合在 Update 的循环里做，不额外过一遍内存
+class FlakeCodec
+{
+  public:
+    static const int FLAG_LANDED = 1;
+
+    // tile：定点坐标覆盖的区域 (模拟区域 = 虚拟屏幕 + 出生缓冲区)
+    void SetTile(float originX, float originY, float width, float height);
+
+    // 当前帧号：用它把 16 位的帧号还原成完整的
+    // (着陆帧在 200 帧以内的过去，碰撞检测帧在 1024 帧以内的将来)
+    void SetTick(uint32_t tick) { m_tick = tick; }
+
+    bool SameTile(float originX, float originY, float width, float height) const
+    {
+        return originX == m_originX && originY == m_originY &&
+               width == m_width && height == m_height;
+    }
+
+    inline void DecodePos(const CompactFlake &c, float &x, float &y) const
+    {
+        x = m_originX + (float)c.x * m_stepX;
+        y = m_originY + (float)c.y * m_stepY;
+    }
+
+    inline void Decode(const CompactFlake &c, Snowflake &s) const
+    {
+        DecodePos(c, s.x, s.y);
+        s.vx       = (float)c.vx * (1.0f / 256.0f);
+        s.vy       = (float)c.vy * (1.0f / 256.0f);
+        s.angle    = (float)c.phase * PHASE_TO_RADIANS;
+        s.maxSize  = (float)c.maxSize * (1.0f / 16.0f);
+        s.size     = s.maxSize * (float)c.sizeScale * (1.0f / 255.0f);
+        s.speed    = (float)c.speed * (1.0f / 32.0f);
+        s.landed   = (c.flags & FLAG_LANDED) != 0;
+        s.landTick = m_tick - (uint16_t)((uint16_t)m_tick - c.eventTick);
+        s.hitTick  = m_tick + (int16_t)(c.eventTick - (uint16_t)m_tick);
+    }
+
+    // 完整编码 (新生成的雪花、切换存储格式时用)
+    inline void Encode(const Snowflake &s, CompactFlake &c, float dither) const
+    {
+        c.maxSize = Quantize8(s.maxSize * 16.0f + 0.5f);
+        c.speed   = Quantize8(s.speed * 32.0f + 0.5f);
+        EncodeState(s, c, dither);
+    }
+
+    // 只写回每帧会变的字段 (maxSize、speed 出生后就不变，不用再量化一遍)
+    // dither 是 [0, 1) 的随机抖动：坐标用随机舍入，
+    // 否则每帧只挪零点几个量化单位的雪花会被四舍五入“钉死”
+    inline void EncodeState(const Snowflake &s, CompactFlake &c, float dither) const
+    {
+        c.x         = Quantize16((s.x - m_originX) * m_invStepX + dither);
+        c.y         = Quantize16((s.y - m_originY) * m_invStepY + dither);
+        c.vx        = QuantizeVelocity(s.vx);
+        c.vy        = QuantizeVelocity(s.vy);
+        c.phase     = (uint16_t)(int64_t)(s.angle * RADIANS_TO_PHASE + 0.5f);
+        c.sizeScale = Quantize8(s.size / s.maxSize * 255.0f + 0.5f);
+        c.flags     = s.landed ? FLAG_LANDED : 0;
+        c.eventTick = (uint16_t)(s.landed ? s.landTick : DueTick(s.hitTick));
+    }
+
+    // 正弦查表：1024 段 + 线性插值 (4KB)，摇摆用，精度远超肉眼
+    // 角度必须 >= 0 (雪花的相位只增不减)
+    static inline float Sin(float radians)
+    {
+        float   f    = radians * (SIN_TABLE_SIZE / 6.2831853f);
+        int64_t i    = (int64_t)f;
+        float   frac = f - (float)i;
+        int     idx  = (int)(i & (SIN_TABLE_SIZE - 1));
+        return s_sinTable[idx] + (s_sinTable[idx + 1] - s_sinTable[idx]) * frac;
+    }
+
+    // 每颗雪花每帧不同的抖动值 (整数哈希，不用随机数发生器)
+    static inline float Dither(uint32_t index, uint32_t tick)
+    {
+        uint32_t h = index * 2654435761u ^ tick * 40503u;
+        h ^= h >> 15;
+        h *= 2246822519u;
+        h ^= h >> 13;
+        return (float)(h >> 8) * (1.0f / 16777216.0f);
+    }
+
+  private:
+    static const int SIN_TABLE_SIZE = 1024;
+
+    static constexpr float PHASE_TO_RADIANS = 6.2831853f / 65536.0f;
+    static constexpr float RADIANS_TO_PHASE = 65536.0f / 6.2831853f;
+
+    // 已经过期的检测帧 (比如刚出生的 0) 一律记成“就是现在”，
+    // 否则 16 位回绕以后可能被当成很远的将来
+    inline uint32_t DueTick(uint32_t hitTick) const
+    {
+        return (int32_t)(hitTick - m_tick) < 0 ? m_tick : hitTick;
+    }
+
+    static inline uint16_t Quantize16(float v)
+    {
+        return v <= 0.0f ? 0 : (v >= 65535.0f ? 65535 : (uint16_t)v);
+    }
+
+    static inline uint8_t Quantize8(float v)
+    {
+        return v <= 0.0f ? 0 : (v >= 255.0f ? 255 : (uint8_t)v);
+    }
+
+    static inline int16_t QuantizeVelocity(float v)
+    {
+        float q = v * 256.0f;
+        q       = q < -32767.0f ? -32767.0f : (q > 32767.0f ? 32767.0f : q);
+        return (int16_t)(q < 0.0f ? q - 0.5f : q + 0.5f);
+    }
+
+    float m_originX  = 0.0f;
+    float m_originY  = 0.0f;
+    float m_width    = 1.0f;
+    float m_height   = 1.0f;
+    float m_stepX    = 1.0f;
+    float m_stepY    = 1.0f;
+    float m_invStepX = 1.0f;
+    float m_invStepY = 1.0f;
+
+    uint32_t m_tick = 0;
+
+    // 多存一个点，插值时不用回绕下标
+    static float      s_sinTable[SIN_TABLE_SIZE + 1];
+    static const bool s_sinTableReady;
+    static bool       BuildSinTable();
+};
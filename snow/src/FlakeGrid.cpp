@@ -0,0 +1,36 @@
+#include "FlakeGrid.h"
+
+// 计数排序：两遍扫描，O(n)，没有任何比较
+// 雪花每帧只挪一两个像素，上一帧排好的顺序这一帧基本还是对的：
+// 完全没变就直接跳过搬运；变了也是稳定排序，搬运时几乎是顺序读写
+
+// 准备网格和计数数组
+void FlakeGrid::BeginSort(size_t count,
+                          float  originX,
+                          float  originY,
+                          float  width,
+                          float  height)
+{
+    m_originX = originX;
+    m_originY = originY;
+    m_cols    = (int)(width * m_invCellSize) + 1;
+    m_rows    = (int)(height * m_invCellSize) + 1;
+
+    m_cellStart.assign((size_t)m_cols * m_rows + 1, 0);
+    m_cellOf.resize(count);
+}
+
+// 前缀和，并准备搬运用的写指针；返回 false 表示不用搬
+bool FlakeGrid::FinishCounts(bool inOrder)
+{
+    size_t cellCount = (size_t)m_cols * m_rows;
+    for (size_t c = 0; c < cellCount; ++c)
+        m_cellStart[c + 1] += m_cellStart[c];
+
+    // 已经有序：区间已经算好了
+    if (inOrder)
+        return false;
+
+    m_cursor.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+    return true;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Snowflake.h"
+
+// 均匀网格：用计数排序把雪花本身按屏幕格子重新排列
+// 排完以后同一个格子里的雪花在内存里是连续的一段：
+//   - Update/Render 顺序遍历时，相邻的雪花在屏幕上也挨着 (缓存友好)
+//   - 空间查询 (鼠标、障碍物、裁剪……) 只需要看附近几个格子的区间
+class FlakeGrid
+{
+  public:
+    // 重新分桶并排序，网格覆盖 [originX, originX + width) x [originY, originY + height)
+    // 超出范围的雪花归到最边上的格子里，不会丢
+    // 返回 true 表示雪花的顺序变了 (之前记下的下标全部失效)
+    bool Sort(std::vector<Snowflake> &flakes,
+              float                   originX,
+              float                   originY,
+              float                   width,
+              float                   height)
+    {
+        return SortItems(flakes,
+                         m_scratch,
+                         originX,
+                         originY,
+                         width,
+                         height,
+                         [](const Snowflake &s, float &x, float &y) {
+                             x = s.x;
+                             y = s.y;
+                         });
+    }
+
+    // 通用版本：任意存储格式 (比如紧凑雪花)，posOf(item, x, y) 负责取坐标
+    // scratch 由调用方提供，和 items 交替使用
+    template <typename T, typename PosFn>
+    bool SortItems(std::vector<T> &items,
+                   std::vector<T> &scratch,
+                   float           originX,
+                   float           originY,
+                   float           width,
+                   float           height,
+                   PosFn         &&posOf)
+    {
+        size_t count = items.size();
+        BeginSort(count, originX, originY, width, height);
+
+        // 1. 数一数每个格子有多少颗，顺便看看是不是已经有序
+        bool     inOrder  = true;
+        uint32_t prevCell = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            float x, y;
+            posOf(items[i], x, y);
+
+            uint32_t cell = (uint32_t)(CellY(y) * m_cols + CellX(x));
+            m_cellOf[i]   = cell;
+            m_cellStart[cell + 1]++;
+
+            if (cell < prevCell)
+                inOrder = false;
+            prevCell = cell;
+        }
+
+        // 2. 前缀和 -> 每个格子的起点；已经有序的话一颗都不用搬
+        if (!FinishCounts(inOrder))
+            return false;
+
+        // 3. 按格子把雪花搬到新位置 (同一格子内保持原来的相对顺序)
+        scratch.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t dst = m_cursor[m_cellOf[i]]++;
+            scratch[dst] = items[i];
+        }
+
+        items.swap(scratch);
+        return true;
+    }
+
+    // 遍历和矩形相交的每个格子，回调 fn(begin, end)
+    // 同一行里相邻格子的区间是首尾相连的，直接合并成一段
+    // 注意：是“格子”级别的粗筛，调用方还要自己做精确判断
+    template <typename Fn>
+    void ForEachRangeInRect(float left,
+                            float top,
+                            float right,
+                            float bottom,
+                            Fn  &&fn) const
+    {
+        if (m_cols == 0 || m_rows == 0)
+            return;
+
+        int c0 = CellX(left);
+        int c1 = CellX(right);
+        int r0 = CellY(top);
+        int r1 = CellY(bottom);
+
+        for (int r = r0; r <= r1; ++r)
+        {
+            uint32_t begin = m_cellStart[r * m_cols + c0];
+            uint32_t end   = m_cellStart[r * m_cols + c1 + 1];
+            if (begin < end)
+                fn(begin, end);
+        }
+    }
+
+    // 逐颗遍历矩形附近的雪花下标
+    template <typename Fn>
+    void ForEachInRect(float left, float top, float right, float bottom, Fn &&fn)
+        const
+    {
+        ForEachRangeInRect(left, top, right, bottom, [&](uint32_t b, uint32_t e) {
+            for (uint32_t k = b; k < e; ++k)
+                fn(k);
+        });
+    }
+
+  private:
+    // 排序的公共部分 (见 FlakeGrid.cpp)
+    void BeginSort(size_t count,
+                   float  originX,
+                   float  originY,
+                   float  width,
+                   float  height);
+    bool FinishCounts(bool inOrder);
+
+    int CellX(float x) const
+    {
+        int c = (int)((x - m_originX) * m_invCellSize);
+        return c < 0 ? 0 : (c >= m_cols ? m_cols - 1 : c);
+    }
+
+    int CellY(float y) const
+    {
+        int r = (int)((y - m_originY) * m_invCellSize);
+        return r < 0 ? 0 : (r >= m_rows ? m_rows - 1 : r);
+    }
+
+    // 格子边长 128 像素：鼠标半径 100 时，一次查询大约只碰 9 个格子
+    float m_cellSize    = 128.0f;
+    float m_invCellSize = 1.0f / 128.0f;
+
+    float m_originX = 0.0f;
+    float m_originY = 0.0f;
+    int   m_cols    = 0;
+    int   m_rows    = 0;
+
+    std::vector<uint32_t>  m_cellStart;  // 每个格子的起点 (+1 哨兵)
+    std::vector<uint32_t>  m_cursor;     // 排序时每个格子的写指针
+    std::vector<uint32_t>  m_cellOf;     // 每颗雪花所在的格子
+    std::vector<Snowflake> m_scratch;    // 排序的目标缓冲 (和原数组交替使用)
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <windows.h>
+#include "FramePacer.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Windows 上的帧时钟：QueryPerformanceCounter 计时 + 高精度可等待计时器
+// 计时器的句柄可以直接交给 MsgWaitForMultipleObjects，
+// 这样 UI 线程在等下一帧的时候照样处理消息
+class WaitableTimerClock : public FrameClock
+{
+  public:
+    WaitableTimerClock()
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        m_frequency = freq.QuadPart;
+
+        // 高精度计时器 (Win10 1803+) 不受系统时钟中断 (15.6ms) 的限制；
+        // 老系统上退回普通的
+        m_hTimer = CreateWaitableTimerExW(nullptr,
+                                          nullptr,
+                                          CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                          TIMER_ALL_ACCESS);
+        if (!m_hTimer)
+            m_hTimer = CreateWaitableTimerW(nullptr, FALSE, nullptr);
+    }
+
+    ~WaitableTimerClock()
+    {
+        if (m_hTimer)
+            CloseHandle(m_hTimer);
+    }
+
+    int64_t Now() override
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        // 分两段算，避免 counter * 1000000 溢出
+        int64_t seconds = counter.QuadPart / m_frequency;
+        int64_t rest    = counter.QuadPart % m_frequency;
+        return seconds * 1000000 + rest * 1000000 / m_frequency;
+    }
+
+    void WaitUntil(int64_t deadline) override
+    {
+        if (Arm(deadline))
+            WaitForSingleObject(m_hTimer, INFINITE);
+    }
+
+    // 让计时器在 deadline 响，已经过了就返回 false
+    bool Arm(int64_t deadline)
+    {
+        int64_t remain = deadline - Now();
+        if (remain <= 0 || !m_hTimer)
+            return false;
+
+        // 负数 = 相对时间，单位 100ns
+        LARGE_INTEGER due;
+        due.QuadPart = -remain * 10;
+        return SetWaitableTimer(m_hTimer, &due, 0, nullptr, nullptr, FALSE) !=
+               FALSE;
+    }
+
+    HANDLE Handle() const { return m_hTimer; }
+
+  private:
+    int64_t m_frequency = 1;
+    HANDLE  m_hTimer    = nullptr;
+};
@@ -0,0 +1,80 @@
+#include "FramePacer.h"
+#include <chrono>
+#include <thread>
+
+int64_t SteadyFrameClock::Now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void SteadyFrameClock::WaitUntil(int64_t deadline)
+{
+    // sleep 的精度靠不住：先睡到差 1ms，最后一小段转圈等
+    int64_t remain = deadline - Now();
+    if (remain > 1000)
+        std::this_thread::sleep_for(std::chrono::microseconds(remain - 1000));
+
+    while (Now() < deadline)
+        std::this_thread::yield();
+}
+
+void FramePacer::SetTargetFps(double fps)
+{
+    fps         = fps < 1.0 ? 1.0 : (fps > 1000.0 ? 1000.0 : fps);
+    m_targetFps = fps;
+    m_period    = (int64_t)(1000000.0 / fps + 0.5);
+    m_deadline  = 0;
+}
+
+int64_t FramePacer::WaitNextFrame()
+{
+    if (m_deadline != 0)
+        m_clock.WaitUntil(m_deadline);
+    return BeginFrame();
+}
+
+int64_t FramePacer::BeginFrame()
+{
+    int64_t now = m_clock.Now();
+    m_frames++;
+
+    // 第一帧 (或者刚改过帧率)：从现在开始排
+    if (m_deadline == 0)
+    {
+        m_lastLateness = 0;
+        m_deadline     = now + m_period;
+        return now;
+    }
+
+    // 早醒了 (调用方没等够) 就当准点
+    int64_t late   = now > m_deadline ? now - m_deadline : 0;
+    m_lastLateness = late;
+
+    // 晚了几整帧就跳过几帧，下一个截止时间仍然对齐原来的节拍
+    int64_t skipped = late / m_period;
+    m_missed += (uint64_t)skipped;
+    m_deadline += (skipped + 1) * m_period;
+    return now;
+}
+
+int FixedStep::Advance(int64_t now)
+{
+    if (m_simTime == 0)
+        m_simTime = now - m_step;  // 第一帧马上跑一步
+
+    int steps = 0;
+    for (; steps < m_maxSteps && now - m_simTime >= m_step; ++steps)
+        m_simTime += m_step;
+    m_steps += (uint64_t)steps;
+
+    // 补不完的丢掉，剩下不到一步的零头留着 (节拍的相位不变)
+    if (now - m_simTime >= m_step)
+    {
+        int64_t behind = (now - m_simTime) / m_step;
+        m_dropped += (uint64_t)behind;
+        m_simTime += behind * m_step;
+    }
+    return steps;
+}
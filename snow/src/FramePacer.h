@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+
+// 帧时钟：时间统一用微秒
+// 真正运行时用高精度计时器，测试时可以换成假的时钟 (时间由测试自己推)
+class FrameClock
+{
+  public:
+    virtual ~FrameClock() {}
+
+    virtual int64_t Now() = 0;
+
+    // 一直等到 deadline (允许早醒或者晚醒，节奏由 FramePacer 自己校正)
+    virtual void WaitUntil(int64_t deadline) = 0;
+};
+
+// 可移植的默认时钟：std::chrono::steady_clock + sleep
+class SteadyFrameClock : public FrameClock
+{
+  public:
+    int64_t Now() override;
+    void    WaitUntil(int64_t deadline) override;
+};
+
+// 帧节奏控制：以前靠 SetTimer(33)，实际帧率跟着系统时钟中断在 21~32 之间晃，
+// 也没法跑 60/120/144。现在按目标帧率排一串固定间隔的截止时间：
+//   - 醒晚了不会把后面的帧整体往后推 (不漂移)
+//   - 晚了整整一帧以上，中间那几帧直接跳过，记作错过的截止时间
+class FramePacer
+{
+  public:
+    explicit FramePacer(FrameClock &clock) : m_clock(clock) {}
+
+    // 目标帧率 (1~1000)，改了以后从现在重新开始排
+    void   SetTargetFps(double fps);
+    double TargetFps() const { return m_targetFps; }
+
+    // 一帧的间隔 (微秒)
+    int64_t Period() const { return m_period; }
+
+    // 下一帧的截止时间 (还没开始过就是 0)
+    int64_t NextDeadline() const { return m_deadline; }
+
+    // 到点了没有
+    bool FrameDue() { return m_deadline == 0 || m_clock.Now() >= m_deadline; }
+
+    // 阻塞等到下一帧，返回这一帧的开始时间
+    int64_t WaitNextFrame();
+
+    // 不阻塞的版本：调用方 (比如消息循环) 自己等到 NextDeadline() 以后调用
+    int64_t BeginFrame();
+
+    // --- 统计 ---
+    uint64_t Frames() const { return m_frames; }
+    uint64_t MissedDeadlines() const { return m_missed; }
+
+    // 最近一帧比截止时间晚了多少微秒
+    int64_t LastLateness() const { return m_lastLateness; }
+
+  private:
+    FrameClock &m_clock;
+
+    double  m_targetFps = 30.0;
+    int64_t m_period    = 33333;
+    int64_t m_deadline  = 0;
+
+    uint64_t m_frames       = 0;
+    uint64_t m_missed       = 0;
+    int64_t  m_lastLateness = 0;
+};
+
+// 固定步长的模拟节拍：所有物理量都是按固定的一步调的，
+// 显示帧率再高模拟也按这个节拍走，中间的帧按速度往前推一点 (Ahead)
+// 卡太久了 (拖窗口、休眠……) 最多补 maxSteps 步，欠的不补了，只保留节拍的相位
+class FixedStep
+{
+  public:
+    FixedStep(int64_t step, int maxSteps) : m_step(step), m_maxSteps(maxSteps)
+    {
+    }
+
+    // 显示帧开始时 (now) 调一次，返回这一帧该跑几步模拟
+    int Advance(int64_t now);
+
+    // 最后一步之后又过了几分之几步 ([0, 1))，快照按它往前推
+    float Ahead(int64_t now) const
+    {
+        return (float)(now - m_simTime) / (float)m_step;
+    }
+
+    int64_t  Step() const { return m_step; }
+    uint64_t Steps() const { return m_steps; }
+    uint64_t DroppedSteps() const { return m_dropped; }
+
+  private:
+    int64_t m_step;
+    int     m_maxSteps;
+    int64_t m_simTime = 0;  // 模拟已经跑到的时间
+
+    uint64_t m_steps   = 0;
+    uint64_t m_dropped = 0;  // 卡顿以后丢掉没补的步数
+};
@@ -4,14 +4,22 @@
 #include "snow.h"
 #include "SnowEngine.h"
 #include "WindowUtils.h"
+#include "MouseTracker.h"
+#include "SnowPresenter.h"
+#include "FramePacer.h"
+#include "FrameClockWin32.h"
+#include "SnowMetrics.h"
+#include "AllocCounter.h"
+#include "MetricsServer.h"
+#include "StateFile.h"
+#include "SnowFeed.h"
 
 #include <vector>
-#include <d2d1.h>
+#include <string>
 #include <dwmapi.h>
 #include <shellapi.h>  // --- 露露叶新增：托盘图标必须的头文件 ---
 #include <commctrl.h>  // 滑块控件需要这个
 
-#pragma comment(lib, "d2d1.lib")
 #pragma comment(lib, "dwmapi.lib")
 #pragma comment(lib, "comctl32.lib")
 // shell32.lib 通常是默认链接的，如果报错请加上 #pragma comment(lib,
@@ -22,21 +30,37 @@
 #define ID_TRAY_ICON     1001           // 图标 ID
 #define IDM_TRAY_EXIT    1002           // 菜单：退出
 #define IDM_TRAY_SETTING 1003           // 菜单：设置
-#define IDT_TIMER_SNOW   1004           // 雪花刷新定时器
-
-// --- Direct2D 全局变量 ---
-ID2D1Factory                *pD2DFactory    = nullptr;
-ID2D1HwndRenderTarget       *pRenderTarget  = nullptr;
-ID2D1RadialGradientBrush    *pRadialBrush   = nullptr;
-ID2D1GradientStopCollection *pGradientStops = nullptr;
+#define WM_SNOW_CONTROL  (WM_USER + 2)  // 监控端点发来的改参数命令
+#define IDT_TIMER_SNOW   1004           // 模态循环里的备用帧定时器
 
 // --- 定义全局引擎实例 ---
 SnowEngine g_Engine;
 
+// --- 渲染线程 (Direct2D 的资源都归它管) ---
+SnowPresenter g_Presenter;
+
+// --- 帧节奏：高精度计时器按显示器刷新率排帧 (以前是 SetTimer(33)) ---
+WaitableTimerClock g_FrameClock;
+FramePacer         g_Pacer(g_FrameClock);
+
+// 模拟的固定步长：所有物理量 (速度、阻力、融化帧数……) 都是按 33ms 一步调的，
+// 显示帧率再高模拟也按这个节拍走，中间的帧按速度往前推一点
+static const int64_t SIM_STEP_US   = 33333;
+static const int     MAX_SIM_STEPS = 3;  // 卡顿后最多补这么多步，再多就丢掉
+FixedStep            g_SimStep(SIM_STEP_US, MAX_SIM_STEPS);
+
+// --- 监控：计数器一直在记 (只是几次原子写)，端点要命令行加 --metrics 才开 ---
+SnowMetrics   g_Metrics;
+MetricsServer g_MetricsServer;
+
+// --- 共享内存的雪花数据：给别的程序画同一场雪用，命令行加 --feed 才开 ---
+SnowFeedWriter g_Feed;
+
 #define MAX_LOADSTRING 100
 
 // 全局变量:
 HINSTANCE             hInst;
+HWND                  g_hWnd = nullptr;  // 覆盖窗口 (销毁后清空，帧循环就停了)
 WCHAR                 szTitle[MAX_LOADSTRING];
 WCHAR                 szWindowClass[MAX_LOADSTRING];
 std::vector<Obstacle> g_Obstacles;
@@ -46,15 +70,27 @@ NOTIFYICONDATA g_nid = {};  // --- 露露叶新增：托盘图标数据结构 --
 ATOM             MyRegisterClass(HINSTANCE hInstance);
 BOOL             InitInstance(HINSTANCE, int);
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
+void             RunFrame(HWND hWnd);
+void             OnMetricsControl(MetricsServer::ControlParam param,
+                                  float                      value,
+                                  void                      *ctx);
 INT_PTR CALLBACK About(HWND, UINT, WPARAM, LPARAM);
 
+// 设置窗口滑块的范围 (监控端点改参数也夹在这里面)
+static const float GRAVITY_MIN = 0.1f;  // 速度滑块 1~30，除以 10
+static const float GRAVITY_MAX = 3.0f;
+static const float WIND_MIN    = -2.0f;  // 风力滑块 0~40，减 20 再除以 10
+static const float WIND_MAX    = 2.0f;
+static const float MAX_FLAKES  = 100000.0f;  // 紧凑存储的上限
+
 // 全局设置状态
 HWND  g_hSettingsDlg            = nullptr;  // 记录设置窗口是不是开着
 int   g_snowCount               = 1000;     // 记住当前的雪量
 float g_snowSpeed               = 1.0f;     // 记住当前的速度
 float g_snowWind                = 0.0f;     // 记住当前的风力
 bool  g_bEnableMouseInteraction = false;    // 交互功能开关，默认关闭
-POINT g_ptLastMouse = {0, 0};  // 记录上一帧的鼠标位置，用于计算移动
+int   g_renderScale = 0;  // 渲染的缩小倍数 (--render-scale=N)，0 = 按 DPI 自动选
+MouseTracker g_MouseTracker;  // 记录上一帧到这一帧的鼠标轨迹，用于计算移动
 
 // ---------------------------------------------------------
 //  设置窗口的处理函数 (非模态版)
@@ -231,6 +267,13 @@ INT_PTR CALLBACK Settings(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
             float realSpeed = speedPos / 10.0f;
             float realWind  = (windPos - 20) / 10.0f;
 
+            // 雪量滑块没动过就不改雪量：滑块最多 2000，
+            // 命令行 (--compact --count=N)、监控端点设的几万片放不进去，
+            // 照着滑块改会悄悄砍回 2000 以内 (也顺带保住 1050 这种零头)
+            int shownPos = g_snowCount / 100 > 20 ? 20 : g_snowCount / 100;
+            if (countPos == shownPos)
+                realCount = g_snowCount;
+
             // 2. 存入全局变量
             g_snowCount = realCount;
             g_snowSpeed = realSpeed;
@@ -289,84 +332,60 @@ void InitNotifyIcon(HWND hWnd)
 
 void DeleteNotifyIcon() { Shell_NotifyIcon(NIM_DELETE, &g_nid); }
 
-// 渲染函数
-void Render(HWND hWnd)
+// 固定倍数直接用，自动的话每次显示器布局 / DPI 变了重新选一次
+void ApplyRenderScale()
 {
-    if (!pRenderTarget)
-    {
-        RECT rc;
-        GetClientRect(hWnd, &rc);
-        D2D1_SIZE_U size = D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top);
-
-        if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED,
-                                     &pD2DFactory)))
-            return;
-
-        D2D1_PIXEL_FORMAT pixelFormat = D2D1::PixelFormat(
-            DXGI_FORMAT_UNKNOWN, D2D1_ALPHA_MODE_PREMULTIPLIED);
-
-        D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(
-            D2D1_RENDER_TARGET_TYPE_DEFAULT, pixelFormat);
-
-        if (FAILED(pD2DFactory->CreateHwndRenderTarget(
-                props,
-                D2D1::HwndRenderTargetProperties(hWnd, size),
-                &pRenderTarget)))
-            return;
-
-        // 强制 DPI 为 96 (1:1 物理像素)
-        pRenderTarget->SetDpi(96.0f, 96.0f);
+    g_Presenter.SetRenderScale(g_renderScale > 0
+                                   ? g_renderScale
+                                   : WindowUtils::GetAutoRenderScale());
+}
 
-        // 既然能走到这里，说明 RenderTarget 肯定创建成功了。
-        // 通知引擎：旧的 RenderTarget 没了，请把关联的位图资源扔掉，下次重画。
-        g_Engine.DiscardDeviceResources();
+// ---------------------------------------------------------
+//  存档：退出 / 睡眠前存一份，下次启动直接接着下
+// ---------------------------------------------------------
 
-        if (!pRadialBrush)
-        {
-            D2D1_GRADIENT_STOP stops[] = {
-                {0.0f, D2D1::ColorF(D2D1::ColorF::White, 1.0f)},
-                {1.0f, D2D1::ColorF(D2D1::ColorF::White, 0.0f)}};
-
-            if (FAILED(pRenderTarget->CreateGradientStopCollection(
-                    stops,
-                    2,
-                    D2D1_GAMMA_2_2,
-                    D2D1_EXTEND_MODE_CLAMP,
-                    &pGradientStops)))
-                return;
-
-            if (FAILED(pRenderTarget->CreateRadialGradientBrush(
-                    D2D1::RadialGradientBrushProperties(
-                        D2D1::Point2F(0, 0), D2D1::Point2F(0, 0), 0, 0),
-                    pGradientStops,
-                    &pRadialBrush)))
-                return;
-        }
-    }
+// %LOCALAPPDATA%\SnowOverlay\state.bin (目录不存在就建一个)
+static bool GetStatePath(std::wstring &path)
+{
+    WCHAR dir[MAX_PATH];
+    DWORD len = GetEnvironmentVariableW(L"LOCALAPPDATA", dir, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH)
+        return false;
+
+    path = dir;
+    path += L"\\SnowOverlay";
+    CreateDirectoryW(path.c_str(), nullptr);  // 已经有了也没关系
+    path += L"\\state.bin";
+    return true;
+}
 
-    pRenderTarget->BeginDraw();
-    pRenderTarget->Clear(D2D1::ColorF(0, 0, 0, 0));
-    g_Engine.Render(pRenderTarget, pRadialBrush);
+void SaveEngineState()
+{
+    std::wstring path;
+    if (!GetStatePath(path))
+        return;
 
-    HRESULT hr = pRenderTarget->EndDraw();
+    std::vector<uint8_t> data;
+    g_Engine.SaveState(data);
+    WriteWholeFile(path.c_str(), data.data(), data.size());
+}
 
-    // --- 露露叶新增：设备丢失处理 ---
-    if (hr == D2DERR_RECREATE_TARGET)
-    {
-        // 显卡掉了，释放所有资源，下次重来
-        if (pRenderTarget)
-        {
-            pRenderTarget->Release();
-            pRenderTarget = nullptr;
-        }
-        if (pRadialBrush)
-        {
-            pRadialBrush->Release();
-            pRadialBrush = nullptr;
-        }
-        // 通知引擎也扔掉它的图片
-        g_Engine.DiscardDeviceResources();
-    }
+// 读档成功返回 true (设置窗口的数值也跟着对齐)
+bool LoadEngineState(int screenW, int screenH)
+{
+    std::wstring path;
+    if (!GetStatePath(path))
+        return false;
+
+    MappedFile file;
+    if (!file.Open(path.c_str()) ||
+        !g_Engine.LoadState(file.Data(), file.Size(), screenW, screenH))
+        return false;
+
+    g_snowCount = (int)g_Engine.FlakeCount();
+    g_snowSpeed = g_Engine.Gravity();
+    g_snowWind  = g_Engine.Wind();
+    return true;
 }
 
 int APIENTRY wWinMain(_In_ HINSTANCE     hInstance,
@@ -378,7 +397,6 @@ int APIENTRY wWinMain(_In_ HINSTANCE     hInstance,
     SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     INITCOMMONCONTROLSEX icex;
     icex.dwSize = sizeof(INITCOMMONCONTROLSEX);
@@ -400,37 +418,97 @@ int APIENTRY wWinMain(_In_ HINSTANCE     hInstance,
     int screenW = GetSystemMetrics(SM_CXVIRTUALSCREEN);
     int screenH = GetSystemMetrics(SM_CYVIRTUALSCREEN);
 
+    // 有上次的存档 (而且屏幕大小没变) 就直接接着下，加 --fresh 强制重新开场
+    bool resumed = !(lpCmdLine && wcsstr(lpCmdLine, L"--fresh")) &&
+                   LoadEngineState(screenW, screenH);
+
     // 【瀑布式开场】预热障碍物数据
     // 注意：这里 g_Obstacles 已经在 InitInstance 里被填充过一次了
     // 所以 g_Engine 初始化时能读到正确的数据
-    g_Engine.Initialize(screenW, screenH);
+    if (!resumed)
+        g_Engine.Initialize(screenW, screenH);
+
+    // 紧凑存储 (每颗 16 字节，几万片的暴风雪才用得上)：--compact 打开，
+    // --count=N 定雪量 (设置窗口的滑块最多 2000，紧凑存储最多 100000)
+    // 存档本来就是紧凑的，不加 --compact 读回来也还是紧凑的
+    if (lpCmdLine && wcsstr(lpCmdLine, L"--compact"))
+        g_Engine.SetCompactStorage(true);
+    if (lpCmdLine)
+    {
+        const wchar_t *arg = wcsstr(lpCmdLine, L"--count=");
+        if (arg)
+        {
+            g_Engine.SetFlakeCount(_wtoi(arg + wcslen(L"--count=")));
+            g_snowCount = (int)g_Engine.FlakeCount();
+        }
+    }
+
+    // 中景 / 远景的视差层 (可选)
+    if (lpCmdLine && wcsstr(lpCmdLine, L"--parallax"))
+        g_Engine.SetParallax(true);
+
+    // 内部分辨率：--render-scale=1/2/3 固定，不写或者写 auto 就按显示器 DPI 选
+    if (lpCmdLine)
+    {
+        const wchar_t *arg = wcsstr(lpCmdLine, L"--render-scale=");
+        if (arg)
+            g_renderScale = _wtoi(arg + wcslen(L"--render-scale="));
+    }
+    ApplyRenderScale();
+
+    // 共享内存的雪花数据 (可选)
+    if (lpCmdLine && wcsstr(lpCmdLine, L"--feed"))
+        g_Feed.Open();
+
+    // 本地监控 / 控制端点 (可选)
+    if (lpCmdLine && wcsstr(lpCmdLine, L"--metrics"))
+        g_MetricsServer.Start(g_Metrics, OnMetricsControl, nullptr);
 
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_SNOW));
-    MSG    msg;
+    MSG    msg         = {};
 
-    // --- 露露叶修改：回归最纯朴的消息循环 ---
-    // 不再需要 PeekMessage 和那些复杂的 else 逻辑了
-    // 所有的驱动力都来自 WM_TIMER 消息
-    while (GetMessage(&msg, nullptr, 0, 0))
+    // 消息循环：同时等“下一帧的计时器”和“新消息”，哪个先来处理哪个
+    // (以前靠 WM_TIMER 驱动，精度被系统时钟中断卡死在 15.6ms 的整数倍；
+    //  现在 WM_TIMER 只在模态循环里顶班，见 WM_CREATE)
+    bool running = true;
+    while (running)
     {
-        // 如果消息是发给非模态对话框的，就让对话框自己处理
-        // 否则才分发给主窗口
-        if (!g_hSettingsDlg || !IsDialogMessage(g_hSettingsDlg, &msg))
+        if (!g_hWnd || !g_Pacer.FrameDue())
         {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
+            HANDLE hTimer = g_FrameClock.Handle();
+            if (g_FrameClock.Arm(g_Pacer.NextDeadline()))
+                MsgWaitForMultipleObjectsEx(
+                    1, &hTimer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+            else
+                MsgWaitForMultipleObjectsEx(
+                    0, nullptr, 1, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        }
+
+        if (g_hWnd && g_Pacer.FrameDue())
+            RunFrame(g_hWnd);
+
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+        {
+            if (msg.message == WM_QUIT)
+            {
+                running = false;
+                break;
+            }
+
+            // 如果消息是发给非模态对话框的，就让对话框自己处理
+            // 否则才分发给主窗口
+            if (!g_hSettingsDlg || !IsDialogMessage(g_hSettingsDlg, &msg))
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
         }
     }
 
-    // 资源清理
-    if (pRadialBrush)
-        pRadialBrush->Release();
-    if (pGradientStops)
-        pGradientStops->Release();
-    if (pRenderTarget)
-        pRenderTarget->Release();
-    if (pD2DFactory)
-        pD2DFactory->Release();
+    // 资源清理 (渲染线程在 WM_DESTROY 里已经停了，这里只是保险)
+    g_Presenter.Stop();
+    g_MetricsServer.Stop();
+    g_Feed.Close();
 
     return (int)msg.wParam;
 }
@@ -486,65 +564,150 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 
     UpdateWindow(hWnd);
 
+    g_hWnd = hWnd;
+
     // --- 预热障碍物 ---
     g_Obstacles = WindowUtils::GetObstacles(hWnd);
 
+    // --- 显示器布局 (剔除屏幕之间空隙里的雪花) ---
+    g_Engine.SetViewRects(WindowUtils::GetMonitorRects());
+
+    // --- 帧率跟着显示器的刷新率走 (60/120/144...) ---
+    g_Pacer.SetTargetFps(WindowUtils::GetRefreshRate());
+
+    // --- 启动渲染线程 (第一份快照到了才开始画) ---
+    g_Presenter.SetMetrics(&g_Metrics);
+    g_Presenter.Start(hWnd);
+
     // --- 露露叶新增：创建托盘图标 ---
     InitNotifyIcon(hWnd);
 
     return TRUE;
 }
 
-LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+// 模拟一步 (33ms)
+static void SimulateStep(HWND hWnd)
 {
     static ULONGLONG lastObstacleUpdate = 0;
 
+    // 1. 定时更新障碍物 (每 500ms)
+    ULONGLONG tick = GetTickCount64();
+    if (tick - lastObstacleUpdate > 500)
+    {
+        g_Obstacles        = WindowUtils::GetObstacles(hWnd);
+        lastObstacleUpdate = tick;
+    }
+
+    // 2. 获取屏幕尺寸
+    int sw = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    int sh = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+
+    // 3. 获取鼠标轨迹 (换算到窗口坐标，窗口左上角是虚拟屏幕原点)
+    g_MouseTracker.Sample(GetSystemMetrics(SM_XVIRTUALSCREEN),
+                          GetSystemMetrics(SM_YVIRTUALSCREEN));
+
+    // 3. 调用更新
+    g_Engine.Update(sw, sh, g_Obstacles, g_MouseTracker.Path());
+}
+
+// --- 露露叶新增：心脏跳动逻辑 ---
+// 每个显示帧调用一次：按固定步长补上该跑的模拟步，再交一份快照给渲染线程
+void RunFrame(HWND hWnd)
+{
+    int64_t now  = g_Pacer.BeginFrame();
+    int     step = g_SimStep.Advance(now);
+    for (int i = 0; i < step; ++i)
+        SimulateStep(hWnd);
+    int64_t simDone = g_FrameClock.Now();
+
+    // 4. 渲染：写好快照交给渲染线程，不在这里等 EndDraw
+    // 两个模拟步之间的显示帧，下落的雪花按速度往前推
+    float         ahead    = g_SimStep.Ahead(now);
+    SnowSnapshot &snapshot = g_Presenter.BeginFrame();
+    g_Engine.BuildSnapshot(snapshot, ahead);
+    if (g_Feed.IsOpen())
+        g_Feed.Publish(snapshot);  // 交给渲染线程之前，快照还归这边
+    g_Presenter.Publish();
+
+    // 5. 计数器 (只有 UI 线程写，relaxed 的原子写)
+    int64_t done = g_FrameClock.Now();
+    SnowMetrics::Set(g_Metrics.activeFlakes, g_Engine.FlakeCount());
+    SnowMetrics::Set(g_Metrics.landedFlakes, g_Engine.LandedCount());
+    SnowMetrics::Set(g_Metrics.visibleFlakes, g_Engine.VisibleCount());
+    SnowMetrics::Set(g_Metrics.obstacles, g_Obstacles.size());
+    SnowMetrics::Set(g_Metrics.simUs, simDone - now);
+    SnowMetrics::Set(g_Metrics.snapshotUs, done - simDone);
+    SnowMetrics::Add(g_Metrics.frames);
+    SnowMetrics::Add(g_Metrics.simSteps, step);
+    g_Metrics.missedDeadlines.store(g_Pacer.MissedDeadlines(),
+                                    std::memory_order_relaxed);
+    g_Metrics.allocations.store(AllocCounter::Count(),
+                                std::memory_order_relaxed);
+}
+
+static float Clamp(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// 监控端点收到改参数的命令 (在端点线程里)：转给 UI 线程去改
+// 先夹到和设置窗口一样的范围 (端点绕过了滑块，什么数都可能发过来)，
+// 雪量直接传整数，重力、风力乘 1000 塞进 LPARAM
+void OnMetricsControl(MetricsServer::ControlParam param, float value, void *ctx)
+{
+    UNREFERENCED_PARAMETER(ctx);
+    HWND hWnd = g_hWnd;
+    if (!hWnd)
+        return;
+
+    LPARAM lParam;
+    switch (param)
+    {
+    case MetricsServer::CONTROL_FLAKE_COUNT:
+        // 引擎自己还会按存储格式再夹一次 (5000 / 100000)
+        lParam = (LPARAM)(int)(Clamp(value, 0.0f, MAX_FLAKES) + 0.5f);
+        break;
+    case MetricsServer::CONTROL_GRAVITY:
+        value  = Clamp(value, GRAVITY_MIN, GRAVITY_MAX);
+        lParam = (LPARAM)(LONG)(value * 1000.0f);
+        break;
+    case MetricsServer::CONTROL_WIND:
+        value  = Clamp(value, WIND_MIN, WIND_MAX);
+        lParam = (LPARAM)(LONG)(value * 1000.0f);
+        break;
+    default:
+        return;
+    }
+    PostMessage(hWnd, WM_SNOW_CONTROL, (WPARAM)param, lParam);
+}
+
+LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
     switch (message)
     {
     case WM_CREATE:
-        // 1. 开启雪花定时器 (如果你之前是在 WinMain
-        // 里开的，这里可以不写，但建议统一放在这)
-        SetTimer(hWnd, IDT_TIMER_SNOW, 33, NULL);
+        // 备用的帧定时器：平时帧由主循环按高精度计时器排，
+        // 但托盘菜单、关于框、拖动窗口时线程被系统的模态循环占着，
+        // 主循环转不起来，只有 WM_TIMER 还会被派发，靠它接着跑，雪不会停住
+        // (系统定时器最快 15.6ms 一次，这时帧率会掉一些，但比冻住强)
+        SetTimer(hWnd, IDT_TIMER_SNOW, USER_TIMER_MINIMUM, NULL);
 
-        // 2. 这里的核心任务：假装用户点击了“设置”，让窗口弹出来
+        // 这里的核心任务：假装用户点击了“设置”，让窗口弹出来
         // PostMessage 是异步的，等窗口完全显示出来后，设置界面就会弹出来
         PostMessage(hWnd, WM_COMMAND, IDM_TRAY_SETTING, 0);
         break;
 
+    case WM_TIMER:
+        // 只在到点时跑：主循环正常转的时候，帧早就被它跑掉了，这里什么也不做
+        if (wParam == IDT_TIMER_SNOW && g_hWnd && g_Pacer.FrameDue())
+            RunFrame(hWnd);
+        break;
+
     case WM_KEYDOWN:
         if (wParam == VK_ESCAPE)
             DestroyWindow(hWnd);
         break;
 
-        // --- 露露叶新增：心脏跳动逻辑 ---
-    case WM_TIMER:
-        if (wParam == IDT_TIMER_SNOW)
-        {
-            // 1. 定时更新障碍物 (每 500ms)
-            ULONGLONG tick = GetTickCount64();
-            if (tick - lastObstacleUpdate > 500)
-            {
-                g_Obstacles        = WindowUtils::GetObstacles(hWnd);
-                lastObstacleUpdate = tick;
-            }
-
-            // 2. 获取屏幕尺寸
-            int sw = GetSystemMetrics(SM_CXVIRTUALSCREEN);
-            int sh = GetSystemMetrics(SM_CYVIRTUALSCREEN);
-
-            // 3. 获取鼠标位置
-            POINT ptMouse;
-            GetCursorPos(&ptMouse);  // 获取全局鼠标坐标
-
-            // 3. 调用更新
-            g_Engine.Update(sw, sh, g_Obstacles, ptMouse);
-
-            // 4. 渲染
-            Render(hWnd);
-        }
-        break;
-
-    // --- 露露叶新增：处理托盘消息 ---
     case WM_TRAYICON:
         // lParam 包含了具体的鼠标事件 (如 WM_RBUTTONUP, WM_LBUTTONDBLCLK)
         if (lParam == WM_RBUTTONUP)
@@ -613,6 +776,46 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     }
     break;
 
+    case WM_SNOW_CONTROL: {
+        // 和设置窗口点“确定”一样：记进全局变量，再交给引擎
+        // (范围在 OnMetricsControl 里已经夹过了)
+        float value = (float)(LONG)lParam / 1000.0f;
+        switch ((MetricsServer::ControlParam)wParam)
+        {
+        case MetricsServer::CONTROL_FLAKE_COUNT:
+            g_Engine.SetFlakeCount((int)lParam);
+            g_snowCount = (int)g_Engine.FlakeCount();
+            break;
+        case MetricsServer::CONTROL_GRAVITY:
+            g_snowSpeed = value;
+            g_Engine.SetGravity(g_snowSpeed);
+            break;
+        case MetricsServer::CONTROL_WIND:
+            g_snowWind = value;
+            g_Engine.SetWind(g_snowWind);
+            break;
+        }
+    }
+    break;
+
+    case WM_DISPLAYCHANGE:
+        // 插拔显示器、改分辨率：重新取一遍显示器布局
+        g_Engine.SetViewRects(WindowUtils::GetMonitorRects());
+        g_Pacer.SetTargetFps(WindowUtils::GetRefreshRate());
+        ApplyRenderScale();
+        break;
+
+    case WM_DPICHANGED:
+        // 改了缩放比例：覆盖窗口的大小不跟着变 (一直铺满虚拟屏幕)，只重选倍数
+        ApplyRenderScale();
+        break;
+
+    case WM_POWERBROADCAST:
+        // 睡眠前存一份：醒不过来 (断电、被强制关机) 下次也能接着下
+        if (wParam == PBT_APMSUSPEND)
+            SaveEngineState();
+        return TRUE;
+
     case WM_PAINT: {
         PAINTSTRUCT ps;
         HDC         hdc = BeginPaint(hWnd, &ps);
@@ -621,7 +824,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     break;
 
     case WM_DESTROY:
-        KillTimer(hWnd, IDT_TIMER_SNOW);  // 关掉定时器
+        KillTimer(hWnd, IDT_TIMER_SNOW);
+        g_hWnd = nullptr;    // 帧循环停下
+        g_Presenter.Stop();  // 渲染线程要在窗口销毁前退出
+        SaveEngineState();
         // 记得在窗口销毁时删除图标，不然它会变成僵尸图标留在任务栏
         DeleteNotifyIcon();
         PostQuitMessage(0);
@@ -0,0 +1,303 @@
+#include "MetricsServer.h"
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#ifdef _WIN32
+#include <windows.h>
+static const char DEFAULT_NAME[] = "\\\\.\\pipe\\SnowMetrics";
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+static const char DEFAULT_NAME[] = "/tmp/snow-metrics.sock";
+#endif
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+std::string MetricsServer::HandleLine(const std::string &line)
+{
+    if (line == "stats")
+    {
+        std::string out;
+        m_pMetrics->Format(out);
+        out += "\n";
+        return out;
+    }
+
+    // set <参数> <数值>
+    char  param[32];
+    float value;
+    if (sscanf(line.c_str(), "set %31s %f", param, &value) == 2)
+    {
+        ControlParam which;
+        if (strcmp(param, "count") == 0)
+            which = CONTROL_FLAKE_COUNT;
+        else if (strcmp(param, "gravity") == 0)
+            which = CONTROL_GRAVITY;
+        else if (strcmp(param, "wind") == 0)
+            which = CONTROL_WIND;
+        else
+            return "error unknown parameter\n";
+
+        // sscanf 认 nan、inf：这种值交给引擎，所有雪花一下子全变 NaN
+        // 范围 (和设置窗口一样) 由回调去夹，这里只挡掉不是数的
+        if (!std::isfinite(value))
+            return "error invalid value\n";
+
+        if (m_handler)
+            m_handler(which, value, m_ctx);
+        return "ok\n";
+    }
+
+    return "error unknown command\n";
+}
+
+template <typename ReadFn, typename WriteFn>
+void MetricsServer::Serve(ReadFn &&read, WriteFn &&write)
+{
+    std::string pending;
+    char        buf[256];
+
+    while (m_bRunning)
+    {
+        int n = read(buf, (int)sizeof(buf));
+        if (n <= 0)
+            break;
+        pending.append(buf, n);
+
+        // 一次可能收到好几行，也可能半行
+        size_t end;
+        while ((end = pending.find('\n')) != std::string::npos)
+        {
+            std::string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+
+            std::string reply = HandleLine(line);
+            if (write(reply.data(), (int)reply.size()) <= 0)
+                return;
+        }
+
+        // 不认识的超长输入，别让它一直攒
+        if (pending.size() > 1024)
+            pending.clear();
+    }
+}
+
+#ifdef _WIN32
+
+// ---------------------------------------------------------
+//  Windows：命名管道 (同一时间只接一个客户端)
+// ---------------------------------------------------------
+
+bool MetricsServer::Start(const SnowMetrics &metrics,
+                          ControlHandler     handler,
+                          void              *ctx,
+                          const char        *name)
+{
+    if (m_bRunning)
+        return true;
+
+    m_pMetrics = &metrics;
+    m_handler  = handler;
+    m_ctx      = ctx;
+    m_name     = name ? name : DEFAULT_NAME;
+
+    m_hStopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (!m_hStopEvent)
+        return false;
+
+    m_bRunning = true;
+    m_thread   = std::thread(&MetricsServer::ThreadProc, this);
+    return true;
+}
+
+void MetricsServer::Stop()
+{
+    if (!m_bRunning)
+        return;
+
+    m_bRunning = false;
+    SetEvent(m_hStopEvent);
+    m_thread.join();
+
+    CloseHandle(m_hStopEvent);
+    m_hStopEvent = nullptr;
+}
+
+// 发起一个重叠 IO，等它完成或者 Stop；返回传输的字节数，失败/停止返回 -1
+static int WaitOverlapped(HANDLE      hPipe,
+                          OVERLAPPED &ov,
+                          BOOL        started,
+                          HANDLE      hStopEvent)
+{
+    if (!started && GetLastError() != ERROR_IO_PENDING)
+        return -1;
+
+    HANDLE handles[2] = {ov.hEvent, hStopEvent};
+    if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+    {
+        CancelIo(hPipe);
+        DWORD ignored;
+        GetOverlappedResult(hPipe, &ov, &ignored, TRUE);
+        return -1;
+    }
+
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(hPipe, &ov, &bytes, FALSE))
+        return -1;
+    return (int)bytes;
+}
+
+void MetricsServer::ThreadProc()
+{
+    HANDLE     hStop = (HANDLE)m_hStopEvent;
+    OVERLAPPED ov    = {};
+    ov.hEvent        = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (!ov.hEvent)
+        return;
+
+    while (m_bRunning)
+    {
+        // 重叠 IO：等客户端、等数据的时候 Stop 都能马上打断
+        HANDLE hPipe = CreateNamedPipeA(
+            m_name.c_str(),
+            PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+                PIPE_REJECT_REMOTE_CLIENTS,
+            1,
+            4096,
+            4096,
+            0,
+            nullptr);
+        if (hPipe == INVALID_HANDLE_VALUE)
+            break;
+
+        ResetEvent(ov.hEvent);
+        BOOL connected = ConnectNamedPipe(hPipe, &ov);
+        if (!connected && GetLastError() == ERROR_PIPE_CONNECTED)
+            connected = TRUE;  // 客户端抢在前面连上了
+        else if (WaitOverlapped(hPipe, ov, connected, hStop) >= 0)
+            connected = TRUE;
+        else
+            connected = FALSE;
+
+        if (connected && m_bRunning)
+        {
+            Serve(
+                [&](char *buf, int size) {
+                    ResetEvent(ov.hEvent);
+                    BOOL ok = ReadFile(hPipe, buf, size, nullptr, &ov);
+                    return WaitOverlapped(hPipe, ov, ok, hStop);
+                },
+                [&](const char *buf, int size) {
+                    ResetEvent(ov.hEvent);
+                    BOOL ok = WriteFile(hPipe, buf, size, nullptr, &ov);
+                    return WaitOverlapped(hPipe, ov, ok, hStop);
+                });
+        }
+
+        DisconnectNamedPipe(hPipe);
+        CloseHandle(hPipe);
+    }
+
+    CloseHandle(ov.hEvent);
+}
+
+#else
+
+// ---------------------------------------------------------
+//  其他平台：Unix 域套接字
+// ---------------------------------------------------------
+
+bool MetricsServer::Start(const SnowMetrics &metrics,
+                          ControlHandler     handler,
+                          void              *ctx,
+                          const char        *name)
+{
+    if (m_bRunning)
+        return true;
+
+    m_pMetrics = &metrics;
+    m_handler  = handler;
+    m_ctx      = ctx;
+    m_name     = name ? name : DEFAULT_NAME;
+
+    sockaddr_un addr = {};
+    addr.sun_family  = AF_UNIX;
+    if (m_name.size() >= sizeof(addr.sun_path))
+        return false;
+    memcpy(addr.sun_path, m_name.c_str(), m_name.size() + 1);
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0)
+        return false;
+
+    unlink(m_name.c_str());  // 上次没删掉的
+    if (bind(m_listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(m_listenFd, 1) != 0)
+    {
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+
+    m_bRunning = true;
+    m_thread   = std::thread(&MetricsServer::ThreadProc, this);
+    return true;
+}
+
+void MetricsServer::Stop()
+{
+    if (!m_bRunning)
+        return;
+
+    // 线程每 100ms 看一次 m_bRunning
+    m_bRunning = false;
+    m_thread.join();
+
+    close(m_listenFd);
+    m_listenFd = -1;
+    unlink(m_name.c_str());
+}
+
+// 等 fd 可读，顺便每 100ms 看一下是不是该停了
+bool MetricsServer::WaitReadable(int fd)
+{
+    while (m_bRunning)
+    {
+        pollfd pfd = {fd, POLLIN, 0};
+        int    n   = poll(&pfd, 1, 100);
+        if (n > 0)
+            return true;
+        if (n < 0)
+            return false;
+    }
+    return false;
+}
+
+void MetricsServer::ThreadProc()
+{
+    while (WaitReadable(m_listenFd))
+    {
+        int fd = accept(m_listenFd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        Serve(
+            [&](char *buf, int size) {
+                return WaitReadable(fd) ? (int)read(fd, buf, size) : -1;
+            },
+            [&](const char *buf, int size) {
+                return (int)send(fd, buf, size, MSG_NOSIGNAL);
+            });
+        close(fd);
+    }
+}
+
+#endif
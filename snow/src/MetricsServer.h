@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <atomic>
+#include "SnowMetrics.h"
+
+// 本地监控 / 控制端点 (默认不开，命令行加 --metrics 才启动)
+// Windows 上是命名管道 \\.\pipe\SnowMetrics (拒绝远程连接)，
+// 其他平台是 Unix 域套接字。协议是一行一条的文本：
+//   stats               -> 每行 "名字 数值"，最后一个空行
+//   set count <n>       -> ok / error ...   (同 SetFlakeCount)
+//   set gravity <x>     ->                  (同 SetGravity)
+//   set wind <x>        ->                  (同 SetWind)
+//   数值不是有限数 (nan、inf) 回 error invalid value；
+//   超出范围的由回调夹到和设置窗口一样的范围
+// 只在自己的线程里读计数器；改参数的命令交给回调 (由回调转回 UI 线程)
+class MetricsServer
+{
+  public:
+    enum ControlParam
+    {
+        CONTROL_FLAKE_COUNT,
+        CONTROL_GRAVITY,
+        CONTROL_WIND
+    };
+
+    // 收到 set 命令时在端点线程里调用
+    typedef void (*ControlHandler)(ControlParam param, float value, void *ctx);
+
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    // name：管道名 / 套接字路径，传 nullptr 用默认的
+    bool Start(const SnowMetrics &metrics,
+               ControlHandler     handler,
+               void              *ctx,
+               const char        *name = nullptr);
+    void Stop();
+
+  private:
+    void ThreadProc();
+
+    // 处理一行命令，返回要回给客户端的内容
+    std::string HandleLine(const std::string &line);
+
+    // 连上以后一直读到客户端断开
+    // (read/write 是平台相关的，返回 <= 0 表示断开)
+    template <typename ReadFn, typename WriteFn>
+    void Serve(ReadFn &&read, WriteFn &&write);
+
+    const SnowMetrics *m_pMetrics = nullptr;
+    ControlHandler     m_handler  = nullptr;
+    void              *m_ctx      = nullptr;
+    std::string        m_name;
+
+    std::thread       m_thread;
+    std::atomic<bool> m_bRunning{false};
+
+#ifdef _WIN32
+    void *m_hStopEvent = nullptr;  // HANDLE，Stop 时亮起来，打断正在等的 IO
+#else
+    int m_listenFd = -1;
+
+    bool WaitReadable(int fd);
+#endif
+};
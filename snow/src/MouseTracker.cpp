@@ -0,0 +1,73 @@
+#include "MouseTracker.h"
+
+// 系统最多只保留最近 64 个鼠标移动点
+static const int MOUSE_HISTORY_SIZE = 64;
+
+void MouseTracker::Sample(int originX, int originY)
+{
+    POINT pt;
+    GetCursorPos(&pt);
+
+    std::vector<POINT> &screenPath = m_screenPath;
+    screenPath.clear();
+    if (m_hasLast)
+        screenPath.push_back(m_last);
+
+    // 向系统要鼠标的移动历史 (从新到旧)
+    // 输入点必须是历史里存在的点，所以直接用当前光标位置去查
+    MOUSEMOVEPOINT current = {};
+    current.x              = pt.x & 0x0000FFFF;
+    current.y              = pt.y & 0x0000FFFF;
+
+    MOUSEMOVEPOINT history[MOUSE_HISTORY_SIZE];
+    int            n = GetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT),
+                                 &current,
+                                 history,
+                                 MOUSE_HISTORY_SIZE,
+                                 GMMP_USE_DISPLAY_POINTS);
+
+    if (m_hasLast && n > 0)
+    {
+        // 只要上一帧之后的点；倒着放进去，变成从旧到新
+        int newer = 0;
+        while (newer < n && (int)(history[newer].time - m_lastTime) > 0)
+            ++newer;
+
+        for (int i = newer - 1; i >= 0; --i)
+        {
+            // 多显示器下负坐标会以 16 位无符号数的形式返回，要还原
+            int x = history[i].x;
+            int y = history[i].y;
+            if (x > 32767)
+                x -= 65536;
+            if (y > 32767)
+                y -= 65536;
+            screenPath.push_back({x, y});
+        }
+    }
+
+    if (n > 0)
+        m_lastTime = history[0].time;
+
+    // 最后补上当前位置 (历史接口失败时，至少还有首尾两点这一段)
+    if (screenPath.empty() || screenPath.back().x != pt.x ||
+        screenPath.back().y != pt.y)
+    {
+        screenPath.push_back(pt);
+    }
+
+    // 换算成窗口坐标，顺便去掉重复点
+    m_path.clear();
+    for (const auto &p : screenPath)
+    {
+        POINT local = {p.x - originX, p.y - originY};
+        if (m_path.empty() || m_path.back().x != local.x ||
+            m_path.back().y != local.y)
+        {
+            m_path.push_back(local);
+        }
+    }
+
+    m_last    = pt;
+    m_hasLast = true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+
+// 鼠标轨迹记录：每帧把“上一帧到这一帧之间”鼠标划过的所有点收集起来
+// 33ms 一帧的时候快速甩鼠标能划过好几百像素，只看当前位置会漏掉中间的雪花
+class MouseTracker
+{
+  public:
+    // 每帧调用一次 (originX/originY 是覆盖窗口左上角的屏幕坐标)
+    // 收集到的点会换算成窗口坐标，和雪花的坐标一致
+    void Sample(int originX, int originY);
+
+    // 本帧的轨迹折线，从旧到新；第一个点是上一帧结束时的位置
+    // 鼠标没动的时候只有一个点
+    const std::vector<POINT> &Path() const { return m_path; }
+
+    // 鼠标这一帧有没有动过
+    bool IsMoving() const { return m_path.size() >= 2; }
+
+  private:
+    std::vector<POINT> m_path;
+
+    // 换算之前的屏幕坐标：每帧都要用，容量留着，稳定以后不再分配
+    std::vector<POINT> m_screenPath;
+
+    POINT m_last     = {0, 0};  // 上一帧结束时的位置 (屏幕坐标)
+    DWORD m_lastTime = 0;       // 上一帧取到的最新一个历史点的时间戳
+    bool  m_hasLast  = false;
+};
@@ -0,0 +1,71 @@
+#include "ObstacleDiff.h"
+#include <algorithm>
+
+bool ObstacleDiff::FindMove(WindowId id, LONG &dx, LONG &dy) const
+{
+    // moved 按 id 排过序，二分查就行 (每颗着陆的雪都要查一次)
+    auto it = std::lower_bound(
+        moved.begin(),
+        moved.end(),
+        id,
+        [](const ObstacleMove &m, WindowId v) { return m.id < v; });
+    if (it == moved.end() || it->id != id)
+        return false;
+
+    dx = it->dx;
+    dy = it->dy;
+    return true;
+}
+
+void ObstacleDiffer::Compute(const std::vector<Obstacle> &prev,
+                             const std::vector<Obstacle> &next,
+                             ObstacleDiff                &diff)
+{
+    diff.Clear();
+
+    // 先把上一次的列表建成 id -> 下标的表，这一次的逐个去查
+    // 同一个窗口在两次列表里的位置不一定一样 (Z 序会变)，所以只能按 id 认
+    // id 为 0 的是没填窗口的障碍物 (手搭的列表)，认不出来，不进表
+    m_prevIndex.clear();
+    for (size_t i = 0; i < prev.size(); ++i)
+    {
+        if (prev[i].id != 0)
+            m_prevIndex[prev[i].id] = i;
+    }
+
+    for (const auto &obs : next)
+    {
+        auto it = obs.id != 0 ? m_prevIndex.find(obs.id) : m_prevIndex.end();
+        // 新出现的窗口：上面还没有雪，不用管
+        // 没了的窗口压根不会出现在 next 里：表面重建后雪脚下空了自己会掉
+        if (it == m_prevIndex.end())
+            continue;
+
+        const RECT &was = prev[it->second].rect;
+        const RECT &now = obs.rect;
+
+        LONG dx = now.left - was.left;
+        LONG dy = now.top - was.top;
+        // 没挪的不记：只有挪了的才要搬雪，列表越短每颗雪查起来越快
+        if (dx == 0 && dy == 0)
+            continue;
+
+        // 大小没变就是整个拖动，雪跟着平移 dx、dy
+        // 大小变了的 (d6c620f 起) 不再当成平移：以前从左边拉大小会被算成
+        // 向右挪 dx，整片雪跟着往右推，贴着右边那一截就被推出窗口掉下去了
+        // 唯一的例外是只从上边拉：左、右、下都没动，雪跟着顶边走 dy 就对了
+        bool sameSize = now.right - now.left == was.right - was.left &&
+                        now.bottom - now.top == was.bottom - was.top;
+        if (sameSize)
+            diff.moved.push_back({obs.id, dx, dy});
+        else if (dx == 0 && now.right == was.right && now.bottom == was.bottom)
+            diff.moved.push_back({obs.id, 0, dy});
+    }
+
+    // 排好序给 FindMove 二分用
+    std::sort(diff.moved.begin(),
+              diff.moved.end(),
+              [](const ObstacleMove &a, const ObstacleMove &b) {
+                  return a.id < b.id;
+              });
+}
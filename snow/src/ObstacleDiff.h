@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include "WindowSource.h"
+
+// 两次障碍物刷新之间，哪些窗口整个平移了 (按 Obstacle::id 认同一个窗口)
+// 只有平移的窗口，堆在上面的雪才跟着走；新出现的、没了的、改了大小的
+// 不用单独记：表面反正整个重建，雪脚下空了自然会掉
+struct ObstacleMove
+{
+    WindowId id;
+    LONG     dx;  // 顶边挪了多少
+    LONG     dy;
+};
+
+struct ObstacleDiff
+{
+    // 按 id 排好序
+    // 大小不变的是拖动，dx、dy 都算；只从上边拉大小的只算 dy
+    // 从左边、右边拉大小的不算：雪要是跟着 dx 走，靠右边的会被推出去
+    std::vector<ObstacleMove> moved;
+
+    void Clear() { moved.clear(); }
+
+    // 这个障碍物挪了多少，没挪返回 false
+    bool FindMove(WindowId id, LONG &dx, LONG &dy) const;
+};
+
+// 比较上一次和这一次的障碍物列表，结果写进 diff
+// 不带 id (id 为 0) 的障碍物没法认，不算挪了
+class ObstacleDiffer
+{
+  public:
+    void Compute(const std::vector<Obstacle> &prev,
+                 const std::vector<Obstacle> &next,
+                 ObstacleDiff                &diff);
+
+  private:
+    // id -> 在 prev 里的下标 (反复复用)
+    std::unordered_map<WindowId, size_t> m_prevIndex;
+};
@@ -0,0 +1,164 @@
+#include "ObstacleFinder.h"
+#include "SurfaceMask.h"
+#include <cwchar>
+
+std::vector<Obstacle> ObstacleFinder::Find(WindowSource &source)
+{
+    std::vector<Obstacle> obstacles;
+    Search(source, nullptr, obstacles);
+    return obstacles;
+}
+
+std::vector<Obstacle> ObstacleFinder::FindCached(WindowSource &source)
+{
+    std::vector<Obstacle> obstacles;
+
+    m_generation++;
+    Search(source, this, obstacles);
+
+    // 这一轮没见到的窗口已经关掉了
+    for (auto it = m_cache.begin(); it != m_cache.end();)
+    {
+        if (it->second.generation != m_generation)
+            it = m_cache.erase(it);
+        else
+            ++it;
+    }
+
+    return obstacles;
+}
+
+void ObstacleFinder::Search(WindowSource          &source,
+                            ObstacleFinder        *pFinder,
+                            std::vector<Obstacle> &obstacles)
+{
+    SearchContext ctx;
+    ctx.pSource = &source;
+    ctx.pResult = &obstacles;
+    ctx.pFinder = pFinder;
+
+    // 1. 获取任务栏
+    RECT rc;
+    if (source.GetTaskbar(rc))
+    {
+        // 任务栏既是障碍物(可积雪)，也是遮挡物
+        obstacles.push_back({rc, true, TASKBAR_ID, {}});
+        ctx.blockers.push_back(rc);
+    }
+
+    // 2. 遍历窗口
+    source.Enumerate(VisitWindow, &ctx);
+}
+
+bool ObstacleFinder::IsFullyCovered(const RECT &target, const RECT &blocker)
+{
+    // 容差修正
+    const long TOLERANCE = 20;
+    return target.left >= (blocker.left - TOLERANCE) &&
+           target.right <= (blocker.right + TOLERANCE) &&
+           target.top >= (blocker.top - TOLERANCE) &&
+           target.bottom <= (blocker.bottom + TOLERANCE);
+}
+
+// 桌面 (Progman / WorkerW) 和我们自己的覆盖窗口不算障碍物
+bool ObstacleFinder::IsIgnoredClass(WindowSource &source, WindowId window)
+{
+    wchar_t className[256];
+    source.GetClass(window, className, 256);
+    return wcscmp(className, L"SnowWindowClass") == 0 ||
+           wcscmp(className, L"Progman") == 0 ||
+           wcscmp(className, L"WorkerW") == 0;
+}
+
+bool ObstacleFinder::VisitWindow(WindowId window, void *ctx)
+{
+    auto         *pCtx   = (SearchContext *)ctx;
+    WindowSource &source = *pCtx->pSource;
+
+    // 带缓存时先查表：类名不会变，第一次见到时判定一次就够了
+    CachedWindow *pCached = nullptr;
+    if (pCtx->pFinder)
+    {
+        auto inserted = pCtx->pFinder->m_cache.try_emplace(window);
+        pCached       = &inserted.first->second;
+        if (inserted.second)
+            pCached->ignored = IsIgnoredClass(source, window);
+
+        pCached->generation = pCtx->pFinder->m_generation;
+        if (pCached->ignored)
+            return true;
+    }
+
+    if (!source.IsVisible(window))
+        return true;
+    if (source.IsMinimized(window))
+        return true;
+
+    if (!pCached && IsIgnoredClass(source, window))
+        return true;
+
+    RECT rcFrame;
+    if (!pCached)
+    {
+        source.GetFrame(window, rcFrame);
+    }
+    else
+    {
+        // 窗口矩形没变，DWM 边框也不会变，不用再去问 DWM
+        RECT bounds;
+        source.GetBounds(window, bounds);
+        if (!pCached->hasFrame || bounds.left != pCached->bounds.left ||
+            bounds.top != pCached->bounds.top ||
+            bounds.right != pCached->bounds.right ||
+            bounds.bottom != pCached->bounds.bottom)
+        {
+            source.GetFrame(window, pCached->frame);
+            ReadTopMask(source, window, pCached->frame, pCached->topMask);
+            pCached->bounds   = bounds;
+            pCached->hasFrame = true;
+        }
+        rcFrame = pCached->frame;
+    }
+
+    // [Step 1] 遮挡检查
+    for (const auto &blocker : pCtx->blockers)
+    {
+        if (IsFullyCovered(rcFrame, blocker))
+            return true;  // 被完全挡住，剔除
+    }
+
+    // [Step 2] 注册为遮挡物 (我是墙！)
+    pCtx->blockers.push_back(rcFrame);
+
+    // [Step 3] 积雪属性判定
+    bool isSlippery = (rcFrame.top < 10);  // 贴顶窗口(最大化)是光滑的
+
+    if (isSlippery)
+    {
+        // 虽然是墙，但不能积雪
+        pCtx->pResult->push_back({rcFrame, false, window, {}});
+    }
+    else
+    {
+        // 正常窗口，可以积雪 (圆角、异形窗口只有实心的那几段顶边能积)
+        pCtx->pResult->push_back({rcFrame, true, window, {}});
+        if (pCached)
+            pCtx->pResult->back().topMask = pCached->topMask;
+        else
+            ReadTopMask(
+                source, window, rcFrame, pCtx->pResult->back().topMask);
+    }
+
+    return true;
+}
+
+void ObstacleFinder::ReadTopMask(WindowSource          &source,
+                                 WindowId               window,
+                                 const RECT            &frame,
+                                 std::vector<uint64_t> &bits)
+{
+    int width = frame.right - frame.left;
+    if (width <= 0 || !source.GetTopMask(window, frame, bits) ||
+        SurfaceMask::AllSolid(bits, width))
+        bits.clear();
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include "WindowSource.h"
+
+// 从一个窗口来源里找出所有障碍物 (原来 WindowUtils 里的 EnumWindowsProc)
+// 只依赖 WindowSource，Windows 上接真正的桌面，基准测试接合成的桌面
+class ObstacleFinder
+{
+  public:
+    // 不带缓存：每个窗口都从头问一遍
+    static std::vector<Obstacle> Find(WindowSource &source);
+
+    // 带缓存：每 500ms 查一次，绝大多数窗口和上次一模一样
+    // 类名只在第一次见到这个窗口时判定一次；窗口矩形没变就沿用上次的
+    // DWM 边框 (跨进程问 DWM 是最贵的一步)。这次枚举没见到的窗口 (关掉了)
+    // 就从缓存里清掉
+    std::vector<Obstacle> FindCached(WindowSource &source);
+
+    size_t CachedWindows() const { return m_cache.size(); }
+    void   ClearCache() { m_cache.clear(); }
+
+  private:
+    struct CachedWindow
+    {
+        bool     ignored    = false;  // 桌面、自己的覆盖窗口：以后直接跳过
+        bool     hasFrame   = false;
+        RECT     bounds     = {};     // 上次的窗口矩形
+        RECT     frame      = {};     // 上次问到的 DWM 边框
+        uint32_t generation = 0;      // 最近一次在哪一轮枚举里见到它
+
+        std::vector<uint64_t> topMask;  // 跟着边框一起更新
+    };
+
+    struct SearchContext
+    {
+        WindowSource          *pSource;
+        std::vector<Obstacle> *pResult;
+        std::vector<RECT>      blockers;
+        ObstacleFinder        *pFinder;  // 不带缓存时为空
+    };
+
+    static bool IsFullyCovered(const RECT &target, const RECT &blocker);
+
+    static bool IsIgnoredClass(WindowSource &source, WindowId window);
+
+    // 顶边的掩码 (整条都实心就留空)
+    static void ReadTopMask(WindowSource          &source,
+                            WindowId               window,
+                            const RECT            &frame,
+                            std::vector<uint64_t> &bits);
+
+    static void Search(WindowSource          &source,
+                       ObstacleFinder        *pFinder,
+                       std::vector<Obstacle> &obstacles);
+
+    static bool VisitWindow(WindowId window, void *ctx);
+
+    // HWND 的值里带着复用计数，关掉的窗口下一轮就被清掉，
+    // 新窗口正好拿到同一个值的情况可以不管
+    std::unordered_map<WindowId, CachedWindow> m_cache;
+    uint32_t                                   m_generation = 0;
+};
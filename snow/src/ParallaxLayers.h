@@ -0,0 +1,33 @@
+#pragma once
+
+// 远景雪 (视差层)
+// 近处的雪花 (SnowEngine 里的) 逐颗模拟、会碰撞会堆积；
+// 中景和远景的雪永远落不到窗口上，不值得逐颗算：
+// 每层预先画好一张可以无缝平铺的小图，整层只按一个偏移量往下滚、随风飘，
+// 画的时候用平铺的位图刷子铺满整个屏幕 (每层一次填充)
+struct ParallaxLayerDesc
+{
+    float fallSpeed;   // 每步往下滚多少像素 (还要乘重力倍率)
+    float windFactor;  // 跟着风飘的比例 (越远越小)
+    float minSize;     // 雪花半径范围
+    float maxSize;
+    float opacity;     // 整层的透明度
+    int   tileSize;    // 平铺小图的边长
+    int   flakesPerTile;
+};
+
+// 从远到近；画的时候也按这个顺序，近处的雪花最后画
+static const ParallaxLayerDesc PARALLAX_LAYERS[] = {
+    {0.45f, 0.25f, 0.8f, 1.6f, 0.35f, 512, 140},  // 远景
+    {0.90f, 0.55f, 1.6f, 3.0f, 0.55f, 512, 45},   // 中景
+};
+
+static const int PARALLAX_LAYER_COUNT =
+    sizeof(PARALLAX_LAYERS) / sizeof(PARALLAX_LAYERS[0]);
+
+// 某一层这一帧滚到了哪里 (取模到一张小图以内)
+struct ParallaxOffset
+{
+    float x;
+    float y;
+};
@@ -1,444 +1,1227 @@
 #include "SnowEngine.h"
 #include <random>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include "StateFile.h"
 
-extern bool  g_bEnableMouseInteraction;
-extern POINT g_ptLastMouse;
+extern bool g_bEnableMouseInteraction;
 
-// 캯
-SnowEngine::SnowEngine() {}
+// 构造函数
+SnowEngine::SnowEngine() : m_rng(std::random_device{}())
+{
+    m_windField.Initialize(m_rng());
+}
 
-// 
-SnowEngine::~SnowEngine()
+SnowEngine::SnowEngine(uint32_t seed) : m_rng(seed)
 {
-    m_snowflakes.clear();
-    DiscardDeviceResources();  // ǵʱͼƬ
+    m_windField.Initialize(m_rng());
 }
 
-// ͷԴԴ
-void SnowEngine::DiscardDeviceResources()
+// 析构函数
+SnowEngine::~SnowEngine() { m_snowflakes.clear(); }
+
+// ---------------------------------------------------------
+//  批量生成雪花
+// ---------------------------------------------------------
+
+// 每一块先批量抽随机数，再用一个紧凑的循环做变换
+static const size_t SPAWN_BLOCK = 256;
+
+// 数量超过这个值才值得开线程 (开场几万片、大风一帧甩出几千片)
+static const size_t SPAWN_PARALLEL_THRESHOLD = 8192;
+
+// 最多切这么多块：种子放在栈上，平时每帧重生几颗不用碰堆
+static const size_t SPAWN_MAX_CHUNKS = 64;
+
+// 把 32 位随机数映射到 (0, 1]，保证 Box-Muller 里的 log 碰不到 0
+static inline float ToUnitFloat(uint32_t bits)
 {
-    if (m_pSnowBitmap)
+    return ((float)(bits >> 8) + 0.5f) * (1.0f / 16777216.0f);
+}
+
+// 生成一段雪花的初始状态 (每个线程跑一段，各用各的发生器)
+static void SpawnKernel(Snowflake *out,
+                        size_t     count,
+                        uint32_t   seed,
+                        float      xMin,
+                        float      xMax,
+                        float      yMin,
+                        float      yMax)
+{
+    std::mt19937 gen(seed);
+
+    // 每颗雪花 5 个均匀数：x、y、两个给 Box-Muller、初始相位
+    float u[5][SPAWN_BLOCK];
+
+    for (size_t base = 0; base < count; base += SPAWN_BLOCK)
     {
-        m_pSnowBitmap->Release();
-        m_pSnowBitmap = nullptr;
+        size_t n = count - base;
+        if (n > SPAWN_BLOCK)
+            n = SPAWN_BLOCK;
+
+        // 1. 一口气抽完这一块要用的均匀随机数
+        for (int k = 0; k < 5; ++k)
+            for (size_t i = 0; i < n; ++i)
+                u[k][i] = ToUnitFloat(gen());
+
+        // 2. 变换：每颗雪花互不依赖，没有数据相关的分支
+        for (size_t i = 0; i < n; ++i)
+        {
+            Snowflake &s = out[base + i];
+
+            s.landed   = false;
+            s.landTick = 0;
+            s.hitTick  = 0;  // 出生的第一帧先做一次碰撞检测，顺便预测
+
+            s.x = xMin + (xMax - xMin) * u[0][i];
+            s.y = yMin + (yMax - yMin) * u[1][i];
+
+            // Box-Muller：一对均匀数换一对标准正态数
+            // n0 给大小用，n1 给速度扰动用
+            float r     = sqrtf(-2.0f * logf(u[2][i]));
+            float theta = 6.2831853f * u[3][i];
+            float n0    = r * cosf(theta);
+            float n1    = r * sinf(theta);
+
+            // === 大小使用正态分布 ===
+            // 均值 5.0 (大部分雪花是中等偏大)，标准差 2.0
+            // [重要] 截断 (Clamp)：最小 2.5，最大 12.0 (偶尔出现的特大雪花)
+            float rawSize = 5.0f + 2.0f * n0;
+            rawSize       = rawSize < 2.5f ? 2.5f : rawSize;
+            rawSize       = rawSize > 12.0f ? 12.0f : rawSize;
+
+            s.maxSize = rawSize;
+            s.size    = rawSize;
+
+            // === 速度与大小挂钩 (模拟景深) ===
+            // 基础速度 + 大小加成 (越大的落得越快)，再加一点正态扰动
+            float speed = 1.0f + (rawSize - 2.5f) * 0.4f + 0.2f * n1;
+
+            // 防止速度过慢倒着飞
+            s.speed = speed < 0.5f ? 0.5f : speed;
+
+            // 出生时已经是终端速度，不用先加速
+            s.vx = 0.0f;
+            s.vy = s.speed;
+
+            // === 初始相位 ===
+            s.angle = 6.28f * u[4][i];
+        }
     }
 }
 
-// ȷֲ
-float SnowEngine::RandomFloat(float min, float max)
+// 批量生成雪花：和以前逐颗 Reset 的规则完全一致，只是一次做一批
+void SnowEngine::SpawnSnowflakes(Snowflake *out,
+                                 size_t     count,
+                                 int        screenWidth,
+                                 float      yMin,
+                                 float      yMax)
 {
-    static std::random_device             rd;
-    static std::mt19937                   gen(rd());
-    std::uniform_real_distribution<float> dis(min, max);
-    return dis(gen);
+    if (count == 0)
+        return;
+
+    // 左右各外扩 300 像素 (Buffer Zone)
+    // 这样风往右吹时，左边 -300 处的雪花会飘进屏幕填补空白
+    float margin = 300.0f;
+    float xMin   = -margin;
+    float xMax   = (float)screenWidth + margin;
+
+    // 决定切几块：数量少就直接在当前线程做完，省掉开线程的开销
+    size_t   chunks = 1;
+    unsigned hw     = std::thread::hardware_concurrency();
+    if (count >= SPAWN_PARALLEL_THRESHOLD && hw > 1)
+    {
+        chunks = count / (SPAWN_PARALLEL_THRESHOLD / 2);
+        if (chunks > hw)
+            chunks = hw;
+        if (chunks > SPAWN_MAX_CHUNKS)
+            chunks = SPAWN_MAX_CHUNKS;
+    }
+    size_t perChunk = (count + chunks - 1) / chunks;
+
+    // 种子统一由 m_rng 发放，保证结果只取决于引擎自己的随机状态
+    uint32_t seeds[SPAWN_MAX_CHUNKS];
+    for (size_t c = 0; c < chunks; ++c)
+        seeds[c] = m_rng();
+
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < chunks; ++c)
+    {
+        size_t first = c * perChunk;
+        if (first >= count)
+            break;
+        size_t n = count - first;
+        if (n > perChunk)
+            n = perChunk;
+        workers.emplace_back(
+            SpawnKernel, out + first, n, seeds[c], xMin, xMax, yMin, yMax);
+    }
+
+    // 第 0 块就在当前线程里做，别让它闲着
+    size_t n0 = count < perChunk ? count : perChunk;
+    SpawnKernel(out, n0, seeds[0], xMin, xMax, yMin, yMax);
+
+    for (auto &t : workers)
+        t.join();
 }
 
-// ֲ̬
-float SnowEngine::RandomNormal(float mean, float stddev)
+// 把这一帧攒下来的重生请求一次做完
+void SnowEngine::FlushRespawnQueue(int screenWidth)
 {
-    static std::random_device rd;
-    static std::mt19937       gen(rd());
+    size_t n = m_respawnQueue.size();
+    if (n == 0)
+        return;
+
+    // 随机出生在屏幕上方
+    m_spawnScratch.resize(n);
+    SpawnSnowflakes(m_spawnScratch.data(), n, screenWidth, -50.0f, -10.0f);
+
+    if (!m_bCompact)
+    {
+        for (size_t i = 0; i < n; ++i)
+            m_snowflakes[m_respawnQueue[i]] = m_spawnScratch[i];
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+            m_codec.Encode(m_spawnScratch[i], m_compact[m_respawnQueue[i]], 0.5f);
+    }
 
-    // ʹ std::normal_distribution ɷϸ˹ֲ
-    std::normal_distribution<float> dis(mean, stddev);
+    m_respawnQueue.clear();
+}
+
+// 湍流对竖直速度的影响只取三成 (上下卷得太厉害看起来像在乱飞)
+static const float TURBULENCE_LIFT = 0.3f;
+
+// 碰撞预测最远看多少帧 (紧凑存储里只有 16 位帧号，不能超过 32767)
+static const uint32_t HIT_HORIZON = 1024;
+
+// 两组障碍物是不是完全一样 (顺序也算)
+static bool SameObstacles(const std::vector<Obstacle> &a,
+                          const std::vector<Obstacle> &b)
+{
+    if (a.size() != b.size())
+        return false;
 
-    return dis(gen);
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].rect.left != b[i].rect.left ||
+            a[i].rect.top != b[i].rect.top ||
+            a[i].rect.right != b[i].rect.right ||
+            a[i].rect.bottom != b[i].rect.bottom ||
+            a[i].canAccumulate != b[i].canAccumulate ||
+            a[i].id != b[i].id || a[i].topMask != b[i].topMask)
+            return false;
+    }
+    return true;
 }
 
-// ѩ״̬
-void SnowEngine::ResetSnowflake(Snowflake &s, int screenWidth, int screenHeight)
+// 空气阻力系数：小雪花更“轻”，跟风跟得更紧
+// 大小 2.5 -> 0.35，大小 12 -> 0.16
+static inline float FlakeDrag(float maxSize)
 {
-    s.landed = false;
-    s.life   = 1.0f;  // Ѫ
+    return 0.35f - (maxSize - 2.5f) * 0.02f;
+}
 
-    // Ҹ 300  (Buffer Zone)
-    // Ҵʱ -300 ѩƮĻհ
-    float margin = 300.0f;
-    s.x          = RandomFloat(-margin, (float)screenWidth + margin);
-    s.y          = RandomFloat(-50.0f, -10.0f);  // ĻϷ
+// 按屏幕格子排序：上一帧的顺序基本还对，所以这一步很便宜
+void SnowEngine::BinSnowflakes()
+{
+    // 分桶范围和 SpawnSnowflakes 的出生区域一致 (左右各 300，上方 60)
+    float margin  = 300.0f;
+    float originX = -margin;
+    float originY = -60.0f;
+    float width   = (float)m_screenWidth + margin * 2.0f;
+    float height  = (float)m_screenHeight + 60.0f;
+
+    if (!m_bCompact)
+    {
+        m_grid.Sort(m_snowflakes, originX, originY, width, height);
+    }
+    else
+    {
+        // 紧凑存储只解出坐标来分桶
+        m_grid.SortItems(m_compact,
+                         m_compactScratch,
+                         originX,
+                         originY,
+                         width,
+                         height,
+                         [this](const CompactFlake &c, float &x, float &y) {
+                             m_codec.DecodePos(c, x, y);
+                         });
+    }
+}
 
-    // === ޸ģСʹֲ̬ ===
-    // ֵ 5.0 (󲿷ѩеƫ)
-    // ׼ 2.0 (һĲ)
-    float rawSize = RandomNormal(5.0f, 2.0f);
+// 紧凑存储的 tile：覆盖整个模拟区域
+// (左右出生缓冲区 300，上方到开场撒雪的 -screenHeight，下方到屏幕底)
+// 屏幕大小变了就用旧 tile 解码、新 tile 重新编码一遍
+void SnowEngine::UpdateCompactTile()
+{
+    float margin  = 300.0f + 32.0f;
+    float originX = -margin;
+    float originY = -(float)m_screenHeight - 64.0f;
+    float width   = (float)m_screenWidth + margin * 2.0f;
+    float height  = (float)m_screenHeight * 2.0f + 128.0f;
+
+    if (m_codec.SameTile(originX, originY, width, height))
+        return;
+
+    FlakeCodec newCodec;
+    newCodec.SetTile(originX, originY, width, height);
+    newCodec.SetTick(m_tick);
+
+    for (auto &c : m_compact)
+    {
+        Snowflake s;
+        m_codec.Decode(c, s);
+        newCodec.EncodeState(s, c, 0.5f);
+    }
+
+    m_codec = newCodec;
+}
+
+// 以前窗口一挪，堆在上面的雪脚下一空就全掉下来了
+// 这时 m_surfaces 还是旧的：按旧的顶边认出每颗雪堆在哪个窗口上，跟着平移
+void SnowEngine::CarryLandedSnow()
+{
+    const auto &edges = m_surfaces.Edges();
+    uint32_t    count = (uint32_t)FlakeCount();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Snowflake s;
+        FlakeAt(i, s);
+        if (!s.landed)
+            continue;
 
-    // [Ҫ] ض (Clamp)
-    // ʹֲ̬ҲҪֹ̫׵ֵ
-    if (rawSize < 2.5f)
-        rawSize = 2.5f;  // С
-    if (rawSize > 12.0f)
-        rawSize = 12.0f;  //  (żֵشѩ)
+        LONG dx, dy;
+        int  edge = m_surfaces.Find(s.x, s.y);
+        if (edge < 0 || !m_obstacleDiff.FindMove(edges[edge].id, dx, dy))
+            continue;
 
-    s.maxSize = rawSize;
-    s.size    = s.maxSize;
+        VisitFlake(i, [dx, dy](Snowflake &f) {
+            f.x += (float)dx;
+            f.y += (float)dy;
+        });
+    }
+}
 
-    // === ٶСҹ (ģ⾰) ===
-    // ٶ + Сӳ (ԽԽ)
-    float baseSpeed = 1.0f + (s.size - 2.5f) * 0.4f;
+// 鼠标斥力：轨迹上的每一段都是一个胶囊体，只检查网格里挨着它的格子
+void SnowEngine::ApplyMouseForce(const std::vector<POINT> &mousePath)
+{
+    float interactionRadius = 100.0f;  // 定义鼠标的“影响半径” (像素)
+    float pushPerPixel = 0.5f;   // 鼠标每划过 1 像素，能把雪花推开多远
+    float maxPower     = 40.0f;  // 单段推力上限，防止甩鼠标时雪花直接飞出屏幕
+    float radiusSq     = interactionRadius * interactionRadius;
 
-    // ٶҲһ̬ŶȻ
-    s.speed = baseSpeed + RandomNormal(0.0f, 0.2f);
+    for (size_t k = 1; k < mousePath.size(); ++k)
+    {
+        float ax = (float)mousePath[k - 1].x;
+        float ay = (float)mousePath[k - 1].y;
+        float bx = (float)mousePath[k].x;
+        float by = (float)mousePath[k].y;
+
+        float segX     = bx - ax;
+        float segY     = by - ay;
+        float segLenSq = segX * segX + segY * segY;
+        if (segLenSq < 1.0f)
+            continue;
 
-    // ֹٶȹŷ
-    if (s.speed < 0.5f)
-        s.speed = 0.5f;
+        float segLen = sqrtf(segLenSq);
+        float moveX  = segX / segLen;
+        float moveY  = segY / segLen;
+
+        // 推力和鼠标速度挂钩：这一段划得越长 (越快)，推得越狠
+        // 同一条轨迹不管采样成几段，总推力都差不多
+        float strength = segLen * pushPerPixel;
+        if (strength > maxPower)
+            strength = maxPower;
+
+        // 胶囊体的包围盒
+        float left   = (ax < bx ? ax : bx) - interactionRadius;
+        float right  = (ax > bx ? ax : bx) + interactionRadius;
+        float top    = (ay < by ? ay : by) - interactionRadius;
+        float bottom = (ay > by ? ay : by) + interactionRadius;
+
+        m_grid.ForEachInRect(left, top, right, bottom, [&](uint32_t i) {
+            VisitFlake(i, [&](Snowflake &s) {
+                if (s.landed)
+                    return;  // 堆积的雪不受鼠标影响
+
+                // 雪花到线段的最近点
+                float t = ((s.x - ax) * segX + (s.y - ay) * segY) / segLenSq;
+                t       = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+                float dx     = s.x - (ax + segX * t);
+                float dy     = s.y - (ay + segY * t);
+                float distSq = dx * dx + dy * dy;
+
+                // 只有在半径内的雪花才受影响
+                if (distSq >= radiusSq)
+                    return;
+
+                float dist = sqrtf(distSq);
+                float dirX, dirY;
+                if (dist > 1.0f)
+                {
+                    dirX = dx / dist;
+                    dirY = dy / dist;
+                }
+                else
+                {
+                    // 正好压在轨迹上：往轨迹的法线方向推
+                    dirX = -moveY;
+                    dirY = moveX;
+                }
 
-    // === ʼλ ===
-    s.angle = RandomFloat(0.0f, 6.28f);
+                // 简单的线性衰减斥力：侧向推开，再顺着鼠标方向带走一点
+                // 推力变成速度冲量而不是瞬移，之后由阻力慢慢消掉：
+                // 冲量 power * k 在阻力 k 下的总位移正好约等于 power
+                float power   = (1.0f - dist / interactionRadius) * strength;
+                float impulse = power * FlakeDrag(s.maxSize);
+                s.vx += (dirX + moveX * 0.3f) * impulse;
+                s.vy += (dirY + moveY * 0.3f) * impulse;
+
+                // 速度被改了，之前的碰撞预测作废
+                s.hitTick = 0;
+            });
+        });
+    }
 }
 
-void SnowEngine::Initialize(int screenWidth, int screenHeight)
+void SnowEngine::Initialize(int screenWidth, int screenHeight, int count)
 {
+    m_screenWidth  = screenWidth;
+    m_screenHeight = screenHeight;
+
+    if (count < 0)
+        count = 0;
+
+    // 开场把整片天空撒满 (y 从 -screenHeight 到 -5)，一次批量生成
     m_snowflakes.clear();
-    int count = 1000;  // ѩ
+    m_snowflakes.resize(count);
+    SpawnSnowflakes(
+        m_snowflakes.data(), count, screenWidth, -(float)screenHeight, -5.0f);
 
-    for (int i = 0; i < count; i++)
+    // 紧凑存储：生成完再整体编码一遍
+    if (m_bCompact)
     {
-        Snowflake s;
-        s.x      = RandomFloat(0.0f, (float)screenWidth);
-        s.y      = RandomFloat(-(float)screenHeight, -5.0f);
-        s.speed  = RandomFloat(1.0f, 2.0f);
-        s.size   = RandomFloat(3.0f, 6.0f);
-        s.angle  = RandomFloat(0.0f, 3.14f * 2);  // ʼǶ
-        s.landed = false;
-        m_snowflakes.push_back(s);
+        m_compact.clear();
+        UpdateCompactTile();
+        m_compact.resize(count);
+        for (int i = 0; i < count; ++i)
+            m_codec.Encode(m_snowflakes[i], m_compact[i], 0.5f);
+        m_snowflakes.clear();
+        m_snowflakes.shrink_to_fit();
     }
 }
 
-void SnowEngine::Update(int                          screenWidth,
-                        int                          screenHeight,
-                        const std::vector<Obstacle> &obstacles,
-                        POINT                        mousePos)
+// 预测这颗雪花最早哪一帧可能穿过某个表面
+// 只看“下面最近的一个表面”，不管它横向在哪：宁可早醒，不会漏掉
+inline uint32_t SnowEngine::PredictHitTick(const Snowflake &s) const
 {
-    float interactionRadius = 100.0f;  // ġӰ뾶 ()
-    float forceStrength = 20.0f;       // 塰֮֡С
+    // 竖直速度的上限：阻力每帧只会把 vy 拉向“终端速度 + 湍流”，
+    // 所以以后的 vy 不会超过 (现在的 vy, 空气速度的上限) 里大的那个
+    float lift  = m_windField.MaxSample() * TURBULENCE_LIFT;
+    float vMax  = s.speed * m_speedFactor + lift;
+    float vMin  = s.speed * m_speedFactor - lift;
+    if (s.vy > vMax)
+        vMax = s.vy;
+
+    // 有可能往上飘 (重力很小、湍流很强)：上面的表面也可能再落回来，不预测了
+    if (vMin < 0.0f || s.vy < 0.0f)
+        return m_tick + 1;
+
+    // 第一个还没完全越过的表面 (越过了但还在宽容度以内的也算)
+    float top;
+    if (!m_surfaces.NextTop(s.y - SurfaceEdges::LANDING_SLACK - 1.0f, top))
+        return m_tick + HIT_HORIZON;  // 下面已经没有能积雪的表面了
+
+    float dist = top - s.y;
+    if (dist <= vMax)
+        return m_tick + 1;
+
+    // k 帧之后最多下落 k * vMax，还碰不到 top
+    uint32_t k = (uint32_t)(dist / vMax);
+    return m_tick + (k < HIT_HORIZON ? k : HIT_HORIZON);
+}
 
-    // жǷƶ
-    bool isMouseMoving =
-        (mousePos.x != g_ptLastMouse.x || mousePos.y != g_ptLastMouse.y);
+// 每颗雪花的一步更新，按这一帧的开关组合编译成 16 个特化版本：
+// kWind       全局风不为 0
+// kTurbulence 湍流开着 (要查风场)
+// kObstacles  有障碍物 (要做碰撞)
+// kLanded     有堆积的雪 (要做融化和脚下安全检查)
+// 关掉的功能连判断都不剩，循环体更短，也更容易被向量化
+// 返回这颗雪花这一帧结束时的状态
+template <bool kWind, bool kTurbulence, bool kObstacles, bool kLanded>
+inline SnowEngine::StepResult
+SnowEngine::StepFlake(Snowflake                   &s,
+                      const std::vector<Obstacle> &obstacles,
+                      float                        windX) const
+{
+    float screenWidth  = (float)m_screenWidth;
+    float screenHeight = (float)m_screenHeight;
 
-    for (auto &s : m_snowflakes)
+    // ================= Case A: 堆积/融化状态 =================
+    // (这一帧开始时一颗堆积的雪都没有的话，整个分支直接编译掉)
+    if (kLanded && s.landed)
     {
-        // ================= Case A: ѻ/ڻ״̬ =================
-        if (s.landed)
-        {
-            bool isStillSafe = false;
+        // 融化进度是按着陆帧号现算的，这里只看它化完了没有
+        // 彻底融化后，回天上重生 (排队，帧末统一处理)
+        if (m_tick - s.landTick >= MELT_TICKS)
+            return STEP_RESPAWN;
 
-            // Z-Order ɨ裺ڽ²ȵĵطǲǱ˸סˣ
-            // ǸطǲǱˡɻѩ״̬
-            for (const auto &obs : obstacles)
+        // 障碍物和上一帧一模一样的话，脚下的情况也不会变，不用再扫
+        if (!m_bObstaclesChanged)
+            return STEP_LANDED;
+
+        bool isStillSafe = false;
+
+        // Z-Order 扫描：检查我现在脚下踩的地方，是不是被别人盖住了？
+        // 或者那个地方是不是变成了“不可积雪”的状态？
+        // (紧凑存储的 y 是定点数，堆在顶边上的可能比 top 小一点点，也算踩在上面)
+        for (const auto &obs : obstacles)
+        {
+            if (s.x >= obs.rect.left && s.x <= obs.rect.right &&
+                s.y >= obs.rect.top - 0.5f && s.y <= obs.rect.bottom)
             {
-                if (s.x >= obs.rect.left && s.x <= obs.rect.right &&
-                    s.y >= obs.rect.top && s.y <= obs.rect.bottom)
+                // 命中了某个窗口 (Z-Order 从上到下)
+                if (abs(s.y - obs.rect.top) < 10.0f)
                 {
-                    // ĳ (Z-Order ϵ)
-                    if (abs(s.y - obs.rect.top) < 10.0f)
+                    // 我在它的表面。
+                    // 只有当它允许积雪时，我才安全。
+                    // 如果它是最大化窗口
+                    // (canAccumulate=false)，那我就站不住了。
+                    if (obs.canAccumulate)
                     {
-                        // ı档
-                        // ֻеѩʱҲŰȫ
-                        // 󻯴
-                        // (canAccumulate=false)Ҿվסˡ
-                        if (obs.canAccumulate)
-                        {
-                            isStillSafe = true;
-                        }
-                        else
-                        {
-                            isStillSafe = false;  // ⻬棬
-                        }
-                        break;  // ҵĽӴ棬ÿ
+                        isStillSafe = true;
                     }
                     else
                     {
-                        // ڲ -> ˵ұס -> ȫ
-                        isStillSafe = false;
-                        break;
+                        isStillSafe = false;  // 光滑表面，滑落
                     }
+                    break;  // 找到了最近的接触面，不用看后面了
+                }
+                else
+                {
+                    // 我在它的内部 -> 说明我被盖住了 -> 不安全
+                    isStillSafe = false;
+                    break;
                 }
             }
+        }
 
-            if (!isStillSafe)
-            {
-                s.landed = false;  // ָ
-                // ΢һ㣬ֹһ֡жײ˸
-                s.y += 2.0f;
-                continue;
-            }
+        if (!isStillSafe)
+        {
+            s.landed = false;  // 恢复下落
+            // 已经化掉的部分不会长回来
+            s.size    = s.maxSize * MeltLife(s.landTick);
+            s.hitTick = 0;  // 马上重新做碰撞检测
+            // 稍微往下推一点，防止下一帧立刻判定碰撞造成闪烁
+            s.y += 2.0f;
+            return STEP_FALLING;
+        }
 
-            // ڻ߼
-            float meltSpeed = 0.005f;
-            s.life -= meltSpeed;
-            s.size = s.maxSize * s.life;
+        return STEP_LANDED;
+    }
 
-            if (s.life <= 0.0f)
-            {
-                // ڻ󣬻
-                ResetSnowflake(s, screenWidth, screenHeight);
-            }
-            continue;
+    // ================= Case B: 空中飘落状态 =================
+    // [摇摆相位]
+    // 既然要随机性，那摇摆的频率(变化快慢)也可以和大小挂钩
+    // 小雪花飘得急(频率高)，大雪花飘得缓(频率低)
+    float frequency = 0.02f + (10.0f - s.size) * 0.005f;
+    s.angle += frequency;
+
+    // 相位只在一圈之内转：一直往上加的话，飘上几天 float 的精度就不够加
+    // 这么小的步长了，摇摆越来越慢，最后干脆停住
+    if (s.angle >= 6.2831853f)
+        s.angle -= 6.2831853f;
+
+    // [摇摆幅度]
+    // sin(s.angle) 产生 -1 ~ 1 的波形
+    // 0.5f 是基础摆动幅度
+    // (查表，和紧凑存储的 16 位相位共用同一张正弦表)
+    float swing = FlakeCodec::Sin(s.angle) * 0.5f;
+
+    // [局部湍流] 从风场纹理里双线性查表，不逐颗算噪声
+    float turbX = 0.0f;
+    float turbY = 0.0f;
+    if (kTurbulence)
+        m_windField.Sample(s.x, s.y, turbX, turbY);
+
+    // === 优化 3: 差异化风力 ===
+    // 我们利用 s.speed (它已经包含了大小信息) 作为系数
+    // 速度快(大/近)的雪花，横向移动也应该快一点 (视差)
+    // 0.5f 是一个调节系数，你可以改
+    // 全局风会随阵风忽强忽弱，再叠加上局部湍流
+    float effectiveWind = (windX + turbX) * (s.speed * 0.5f);
+
+    // === 速度模型：阻力把雪花的速度拉向“空气的速度” ===
+    // 横向：差异化风力；竖向：终端速度 (s.speed 已经由大小决定)
+    // * 全局重力倍率，再加一点湍流的上下卷
+    float airVX = effectiveWind;
+    float airVY = s.speed * m_speedFactor + turbY * TURBULENCE_LIFT;
+
+    // 半隐式积分：阻力项用隐式解 v' = (v + k * vAir) / (1 + k)，
+    // 冲量再大也不会发散；位置用更新后的速度推进
+    float drag    = FlakeDrag(s.maxSize);
+    float invDrag = 1.0f / (1.0f + drag);
+    s.vx          = (s.vx + drag * airVX) * invDrag;
+    s.vy          = (s.vy + drag * airVY) * invDrag;
+
+    // 应用位置更新 (摇摆只是位置上的抖动，不计入速度)
+    float prevX = s.x;
+    float prevY = s.y;
+    s.x += s.vx + swing;
+    s.y += s.vy;
+
+    // 碰撞检测 (没有障碍物时整段编译掉)
+    // 事件驱动：只有到了预测的那一帧才真正去扫障碍物，
+    // 障碍物或者重力/湍流变了的那一帧，所有雪花都重新检测、重新预测
+    if (kObstacles &&
+        (m_bRescheduleHits || (int32_t)(m_tick - s.hitTick) >= 0))
+    {
+        // 连续碰撞检测：看这一帧走过的线段 (而不是终点) 穿过了哪条表面
+        // 速度再快、被鼠标甩得再远也穿不过去；
+        // 表面按高度排好序，二分到附近只看一两条
+        float hitX, hitY;
+        if (m_surfaces.Sweep(prevX, prevY, s.x, s.y, hitX, hitY) &&
+            hitY > 0 && hitY < screenHeight)
+        {
+            // 一切正常，着陆！落点就是线段和表面的交点
+            s.x        = hitX;
+            s.y        = hitY;
+            s.vx       = 0.0f;
+            s.vy       = 0.0f;
+            s.landed   = true;
+            s.landTick = m_tick;
         }
 
-        // ================= Case B: Ʈ״̬ =================
-        // 㣬ֻе[ܿ]  [ڶ] ʱż
-        if (g_bEnableMouseInteraction && isMouseMoving)
-        {
-            float dx = s.x - mousePos.x;
-            float dy = s.y - mousePos.y;
+        if (!s.landed)
+            s.hitTick = PredictHitTick(s);
+    }
 
-            // ƽ
-            float distSq   = dx * dx + dy * dy;
-            float radiusSq = interactionRadius * interactionRadius;
+    // 边界检查
+    // 定义一个宽容度 (Margin)，必须和 SpawnSnowflakes 里保持一致或更大
+    float margin = 300.0f;
 
-            // ֻڰ뾶ڵѩӰ
-            if (distSq < radiusSq && distSq > 1.0f)
-            {
-                float dist = sqrt(distSq);
+    // === 左右循环逻辑修正 ===
+    // 只有当雪花完全飞出缓冲区(跑得老远了)才让它瞬移回来
+    // 这样保证了屏幕边缘的雪花是自然进出的
 
-                float dirX = dx / dist;
-                float dirY = dy / dist;
+    // 向右飞出：飞过 screenWidth + 300 才瞬移到左边 -300
+    if (s.x > screenWidth + margin)
+        s.x = -margin;
 
-                // 򵥵˥
-                float power = (1.0f - dist / interactionRadius) * forceStrength;
+    // 向左飞出：飞过 -300 才瞬移到右边 screenWidth + 300
+    if (s.x < -margin)
+        s.x = (float)screenWidth + margin;
 
-                // ҲԸƶٶȼӳɣĿǰ͹
-                s.x += dirX * power;
-                s.y += dirY * power;
+    // 掉出屏幕下方 -> 排队重生
+    if (s.y > screenHeight)
+        return STEP_RESPAWN;
 
-                // ΢㴹ֱŶֹѩƵ̫
-                s.x += dirX * power * 0.1f;
-            }
-        }
+    return s.landed ? STEP_LANDED : STEP_FALLING;
+}
+
+// 整帧的循环：两种存储格式各一份，循环体都是同一个 StepFlake
+template <bool kWind, bool kTurbulence, bool kObstacles, bool kLanded>
+void SnowEngine::StepSnowflakes(const std::vector<Obstacle> &obstacles,
+                                float                        gust)
+{
+    float  windX       = kWind ? m_windForce * gust : 0.0f;
+    size_t landedCount = 0;
 
-        // [ҡλ]
-        // ȻҪԣҡڵƵ(仯)ҲԺʹСҹ
-        // СѩƮü(Ƶʸ)ѩƮû(Ƶʵ)
-        float frequency = 0.02f + (10.0f - s.size) * 0.005f;
-        s.angle += frequency;
-
-        // [ҡڷ]
-        // sin(s.angle)  -1 ~ 1 Ĳ
-        // 0.5f ǻڶ
-        float swing = sin(s.angle) * 0.5f;
-
-        // === Ż 3: 컯 ===
-        //  s.speed (Ѿ˴СϢ) Ϊϵ
-        // ٶȿ(/)ѩƶҲӦÿһ (Ӳ)
-        // 0.5f һϵԸ
-        float effectiveWind = m_windForce * (s.speed * 0.5f);
-
-        // Ӧλø
-        s.x += effectiveWind + swing;    // 컯 + ҡ
-        s.y += s.speed * m_speedFactor;  // 컯ٶ * ȫ
-
-        // ײ
-        if (s.y > 0 && s.y < screenHeight)
+    if (!m_bCompact)
+    {
+        for (size_t idx = 0; idx < m_snowflakes.size(); ++idx)
         {
-            // ʹΪҪǰĴ (j < i)
-            for (size_t i = 0; i < obstacles.size(); ++i)
+            StepResult r = StepFlake<kWind, kTurbulence, kObstacles, kLanded>(
+                m_snowflakes[idx], obstacles, windX);
+
+            if (r == STEP_RESPAWN)
+                m_respawnQueue.push_back(idx);
+            else if (r == STEP_LANDED)
+                landedCount++;
+        }
+    }
+    else
+    {
+        // 紧凑存储：解码到寄存器里的临时雪花 -> 更新 -> 编码写回
+        // 每颗雪花只读写 16 字节
+        for (size_t idx = 0; idx < m_compact.size(); ++idx)
+        {
+            Snowflake s;
+            m_codec.Decode(m_compact[idx], s);
+
+            bool       wasLanded = s.landed;
+            StepResult r = StepFlake<kWind, kTurbulence, kObstacles, kLanded>(
+                s, obstacles, windX);
+
+            if (r == STEP_RESPAWN)
             {
-                const auto &obs = obstacles[i];
+                m_respawnQueue.push_back(idx);
+                continue;  // 反正要整颗重新生成，不用写回
+            }
 
-                // 1. Ӵ
-                if (s.x >= obs.rect.left && s.x <= obs.rect.right)
-                {
-                    // Ԥһ֡᲻ײ϶
-                    if (s.y >= obs.rect.top &&
-                        s.y <= obs.rect.top + s.speed + 5.0f)
-                    {
-                        // --- ޸ 1 ---
-                        // ϰﱻΪɻѩ (󻯴)
-                        // Ǿͼװûµ
-                        if (!obs.canAccumulate)
-                        {
-                            continue;
-                        }
-
-                        // --- ޸ 2ֲڵ (Raycast) ---
-                        // Ȼײ obs[i]ͷ
-                        bool isOccluded = false;
-                        for (size_t j = 0; j < i; ++j)
-                        {
-                            const auto &higherObs = obstacles[j];
-                            //  (s.x, s.y) Ƿڸ߲㴰ڵľ
-                            if (s.x >= higherObs.rect.left &&
-                                s.x <= higherObs.rect.right &&
-                                s.y >= higherObs.rect.top &&
-                                s.y <= higherObs.rect.bottom)
-                            {
-                                isOccluded = true;
-                                break;
-                            }
-                        }
-
-                        if (isOccluded)
-                        {
-                            // סˣײЧ
-                            continue;
-                        }
-
-                        // һ½
-                        s.y      = (float)obs.rect.top;
-                        s.landed = true;
-                        s.life   = 1.0f;
-                        break;  // ֹͣϰ
-                    }
-                }
+            if (r == STEP_LANDED)
+            {
+                landedCount++;
+
+                // 一直趴着的雪这一帧什么都没变，不用写回
+                if (wasLanded)
+                    continue;
             }
+
+            m_codec.EncodeState(
+                s, m_compact[idx], FlakeCodec::Dither((uint32_t)idx, m_tick));
         }
+    }
 
-        // ߽
-        // һݶ (Margin) ResetSnowflake ﱣһ»
-        float margin = 300.0f;
+    m_landedCount = landedCount;
+}
 
-        // Ļ· -> 
-        if (s.y > screenHeight)
-        {
-            ResetSnowflake(s, screenWidth, screenHeight);
-        }
+void SnowEngine::Update(int                          screenWidth,
+                        int                          screenHeight,
+                        const std::vector<Obstacle> &obstacles,
+                        const std::vector<POINT>    &mousePath)
+{
+    m_screenWidth  = screenWidth;
+    m_screenHeight = screenHeight;
+    m_tick++;
+
+    if (m_bCompact)
+    {
+        UpdateCompactTile();
+        m_codec.SetTick(m_tick);
+    }
+
+    // 障碍物每 500ms 才刷新一次，大部分帧和上一帧完全一样
+    // 一样的话堆积的雪就不用重新检查脚下
+    m_bObstaclesChanged = !SameObstacles(obstacles, m_lastObstacles);
+    if (m_bObstaclesChanged)
+    {
+        m_obstacleDiffer.Compute(m_lastObstacles, obstacles, m_obstacleDiff);
+        if (!m_obstacleDiff.moved.empty() && m_landedCount > 0)
+            CarryLandedSnow();
+
+        m_lastObstacles = obstacles;
+        m_surfaces.Build(obstacles);
+        m_surfaceVersion++;
+    }
+
+    // 障碍物或者预测用到的参数变了，这一帧所有雪花的预测都作废
+    m_bRescheduleHits   = m_bObstaclesChanged || m_bHitParamsChanged;
+    m_bHitParamsChanged = false;
+
+    // 先按格子排好序，后面的空间查询都靠它
+    BinSnowflakes();
+
+    // 鼠标斥力，只有当：[功能开启] 且 [鼠标在动] 时，才计算斥力
+    if (g_bEnableMouseInteraction && mousePath.size() >= 2)
+        ApplyMouseForce(mousePath);
+
+    // 风场每帧推进一次 (只改几个标量)
+    m_windField.Advance(m_windForce);
+    float gust = m_windField.Gust();
+
+    if (m_bParallax)
+        AdvanceParallax(m_windForce * gust);
+
+    // 这些开关整帧都不会变，只在这里判断一次，然后跳进对应的特化版本
+    typedef void (SnowEngine::*StepFn)(const std::vector<Obstacle> &, float);
+    static const StepFn steps[16] = {
+        &SnowEngine::StepSnowflakes<false, false, false, false>,
+        &SnowEngine::StepSnowflakes<false, false, false, true>,
+        &SnowEngine::StepSnowflakes<false, false, true, false>,
+        &SnowEngine::StepSnowflakes<false, false, true, true>,
+        &SnowEngine::StepSnowflakes<false, true, false, false>,
+        &SnowEngine::StepSnowflakes<false, true, false, true>,
+        &SnowEngine::StepSnowflakes<false, true, true, false>,
+        &SnowEngine::StepSnowflakes<false, true, true, true>,
+        &SnowEngine::StepSnowflakes<true, false, false, false>,
+        &SnowEngine::StepSnowflakes<true, false, false, true>,
+        &SnowEngine::StepSnowflakes<true, false, true, false>,
+        &SnowEngine::StepSnowflakes<true, false, true, true>,
+        &SnowEngine::StepSnowflakes<true, true, false, false>,
+        &SnowEngine::StepSnowflakes<true, true, false, true>,
+        &SnowEngine::StepSnowflakes<true, true, true, false>,
+        &SnowEngine::StepSnowflakes<true, true, true, true>,
+    };
 
-        // === ѭ߼ ===
-        // ֻеѩȫɳ(ܵԶ)˲ƻ
-        // ֤ĻԵѩȻ
+    int variant = (m_windForce != 0.0f ? 8 : 0) |
+                  (m_windField.Turbulence() != 0.0f ? 4 : 0) |
+                  (!obstacles.empty() ? 2 : 0) | (m_landedCount > 0 ? 1 : 0);
+    (this->*steps[variant])(obstacles, gust);
 
-        // ҷɳɹ screenWidth + 300 ˲Ƶ -300
-        if (s.x > screenWidth + margin)
-            s.x = -margin;
+    // 这一帧要重生的雪花一次性批量生成 (大风/大量融化时可能有几千颗)
+    FlushRespawnQueue(screenWidth);
+}
 
-        // ɳɹ -300 ˲Ƶұ screenWidth + 300
-        if (s.x < -margin)
-            s.x = (float)screenWidth + margin;
+// 视差层：没有碰撞、没有逐颗的状态，整层一起滚
+// 偏移量取模到一张小图以内，跑多久浮点精度都不会掉
+void SnowEngine::AdvanceParallax(float windX)
+{
+    for (int l = 0; l < PARALLAX_LAYER_COUNT; ++l)
+    {
+        const ParallaxLayerDesc &desc = PARALLAX_LAYERS[l];
+        ParallaxOffset          &off  = m_parallax[l];
+
+        float tile = (float)desc.tileSize;
+        off.x      = fmodf(off.x + windX * desc.windFactor + tile, tile);
+        off.y      = fmodf(off.y + desc.fallSpeed * m_speedFactor, tile);
     }
 }
 
-// ӡ¡
-void SnowEngine::CreateSnowBitmap(ID2D1HwndRenderTarget *pRenderTarget)
+// ---------------------------------------------------------
+//  可见性剔除 + 快照
+// ---------------------------------------------------------
+
+// 一颗雪花画出来的样子
+void SnowEngine::SpriteOf(const Snowflake &s, FlakeSprite &sprite) const
 {
-    // 1. һʱġСΪ 32x32
-    // ǻһȵѩȻȾʱЧ
-    ID2D1BitmapRenderTarget *pCompatibleRenderTarget = nullptr;
-    D2D1_SIZE_F              size = D2D1::SizeF(32.0f, 32.0f);
-
-    HRESULT hr = pRenderTarget->CreateCompatibleRenderTarget(
-        size, &pCompatibleRenderTarget);
-    if (FAILED(hr))
-        return;
+    // 动态调整透明度
+    sprite.x       = s.x;
+    sprite.y       = s.y;
+    sprite.size    = s.size;
+    sprite.opacity = 0.8f;
+    if (s.landed)
+    {
+        // 融化进度现算：堆积的雪在 Update 里一颗都不用碰
+        float life = MeltLife(s.landTick);
+        sprite.size = s.maxSize * life;
+        sprite.opacity *= life;
+    }
+}
 
-    // 2. ʱϻһĽѩ
-    pCompatibleRenderTarget->BeginDraw();
-    pCompatibleRenderTarget->Clear(D2D1::ColorF(0, 0, 0, 0));  // ͸
+// 雪花的外接正方形和矩形有没有重叠
+static inline bool Overlaps(const FlakeSprite &sp, const RECT &r)
+{
+    return sp.x + sp.size > (float)r.left && sp.x - sp.size < (float)r.right &&
+           sp.y + sp.size > (float)r.top && sp.y - sp.size < (float)r.bottom;
+}
 
-    // ʱĽˢ
-    ID2D1RadialGradientBrush    *pTempBrush = nullptr;
-    ID2D1GradientStopCollection *pTempStops = nullptr;
-    D2D1_GRADIENT_STOP           stops[]    = {
-        {0.0f, D2D1::ColorF(D2D1::ColorF::White, 1.0f)},  // İ
-        {1.0f, D2D1::ColorF(D2D1::ColorF::White, 0.0f)}  // Ե͸
-    };
+// 雪花的外接正方形是不是整个在矩形里面
+static inline bool Inside(const FlakeSprite &sp, const RECT &r)
+{
+    return sp.x - sp.size >= (float)r.left &&
+           sp.x + sp.size <= (float)r.right &&
+           sp.y - sp.size >= (float)r.top && sp.y + sp.size <= (float)r.bottom;
+}
+
+// 生成区域左右各多出 300 像素，横向循环也让它们一直活在那里；
+// 多屏不一样大时屏幕之间还有空隙。这些雪花以前照样 DrawBitmap，
+// 现在先剔除一遍，只把看得见的下标紧凑地排进 m_visible
+void SnowEngine::CullSnowflakes()
+{
+    size_t total = FlakeCount();
+    m_visible.resize(total);
 
-    pCompatibleRenderTarget->CreateGradientStopCollection(
-        stops, 2, D2D1_GAMMA_2_2, D2D1_EXTEND_MODE_CLAMP, &pTempStops);
+    float w = (float)m_screenWidth;
+    float h = (float)m_screenHeight;
 
-    if (pTempStops)
+    // 1. 渲染目标的边界：不分支，每颗都先写下标，看得见才往前挪
+    //    (堆积的雪大小由融化进度现算，用选择代替分支)
+    size_t n = 0;
+    if (!m_bCompact)
     {
-        pCompatibleRenderTarget->CreateRadialGradientBrush(
-            D2D1::RadialGradientBrushProperties(
-                D2D1::Point2F(16, 16), D2D1::Point2F(0, 0), 16, 16),
-            pTempStops,
-            &pTempBrush);
+        const Snowflake *flakes = m_snowflakes.data();
+        uint32_t        *out    = m_visible.data();
+        for (size_t i = 0; i < total; ++i)
+        {
+            const Snowflake &s    = flakes[i];
+            float            size = s.landed ? s.maxSize * MeltLife(s.landTick)
+                                             : s.size;
+
+            bool in = (size > 0.1f) & (s.x + size > 0.0f) & (s.x - size < w) &
+                      (s.y + size > 0.0f) & (s.y - size < h);
+            out[n] = (uint32_t)i;
+            n += in;
+        }
     }
+    else
+    {
+        Snowflake   s;
+        FlakeSprite sp;
+        for (size_t i = 0; i < total; ++i)
+        {
+            FlakeAt((uint32_t)i, s);
+            SpriteOf(s, sp);
+
+            bool in = (sp.size > 0.1f) & (sp.x + sp.size > 0.0f) &
+                      (sp.x - sp.size < w) & (sp.y + sp.size > 0.0f) &
+                      (sp.y - sp.size < h);
+            m_visible[n] = (uint32_t)i;
+            n += in;
+        }
+    }
+    m_visible.resize(n);
 
-    if (pTempBrush)
+    // 2. 显示器 / 遮挡窗口：矩形只有几个，只对上一步留下来的雪花做
+    //    只有一块显示器时它就是整个渲染目标，不用再筛
+    bool byMonitor  = m_viewRects.size() > 1;
+    bool byOccluder = false;
+    if (m_bCullOccluded)
     {
-        pCompatibleRenderTarget->FillEllipse(
-            D2D1::Ellipse(D2D1::Point2F(16, 16), 16, 16), pTempBrush);
+        for (const auto &obs : m_lastObstacles)
+            byOccluder |= !obs.canAccumulate;
     }
+    if (!byMonitor && !byOccluder)
+        return;
 
-    pCompatibleRenderTarget->EndDraw();
+    size_t kept = 0;
+    for (uint32_t i : m_visible)
+    {
+        Snowflake   s;
+        FlakeSprite sp;
+        FlakeAt(i, s);
+        SpriteOf(s, sp);
+
+        bool in = !byMonitor;
+        for (size_t k = 0; k < m_viewRects.size() && !in; ++k)
+            in = Overlaps(sp, m_viewRects[k]);
 
-    // 3. ѻõĽȡλͼ (ӡ)
-    pCompatibleRenderTarget->GetBitmap(&m_pSnowBitmap);
+        if (in && byOccluder)
+        {
+            for (const auto &obs : m_lastObstacles)
+            {
+                if (!obs.canAccumulate && Inside(sp, obs.rect))
+                {
+                    in = false;
+                    break;
+                }
+            }
+        }
 
-    // 4. ʱ
-    if (pTempBrush)
-        pTempBrush->Release();
-    if (pTempStops)
-        pTempStops->Release();
-    pCompatibleRenderTarget->Release();
+        if (in)
+            m_visible[kept++] = i;
+    }
+    m_visible.resize(kept);
 }
 
-void SnowEngine::Render(ID2D1HwndRenderTarget    *pRenderTarget,
-                        ID2D1RadialGradientBrush *pBrush)
+// 把这一帧要画的雪花写进快照 (只写剔除后留下的)
+// 下落的雪花一颗一颗交过去；堆积的雪按所在的表面分好组，
+// 渲染线程给每条表面缓存一张图层，只补盖新落下的
+void SnowEngine::BuildSnapshot(SnowSnapshot &snapshot, float ahead)
 {
-    // ӡ¡ûϽһ
-    if (!m_pSnowBitmap)
+    snapshot.screenWidth    = m_screenWidth;
+    snapshot.screenHeight   = m_screenHeight;
+    snapshot.tick           = m_tick;
+    snapshot.surfaceVersion = m_surfaceVersion;
+
+    // 视差层也按 ahead 往前推一点，和近处的雪花一起动
+    snapshot.parallaxLayers = m_bParallax ? PARALLAX_LAYER_COUNT : 0;
+    for (int l = 0; l < snapshot.parallaxLayers; ++l)
     {
-        CreateSnowBitmap(pRenderTarget);
-        if (!m_pSnowBitmap)
-            return;  // ʧܾͱ
+        float drop = PARALLAX_LAYERS[l].fallSpeed * m_speedFactor * ahead;
+        snapshot.parallax[l] = {m_parallax[l].x, m_parallax[l].y + drop};
     }
+    snapshot.sprites.clear();
+    snapshot.landed.clear();
+    snapshot.layers.clear();
+
+    CullSnowflakes();
+
+    const auto &edges = m_surfaces.Edges();
+    m_edgeCounts.assign(edges.size(), 0);
+    m_landedScratch.clear();
+
+    for (uint32_t i : m_visible)
+    {
+        Snowflake   s;
+        FlakeSprite sp;
+        FlakeAt(i, s);
+        SpriteOf(s, sp);
+
+        // 找不到表面的 (比如刚好压在两段的接缝上) 还是当普通雪花画
+        int edge = s.landed ? m_surfaces.Find(s.x, s.y) : -1;
+        if (edge < 0)
+        {
+            // 两步模拟之间的显示帧：按速度外推 (堆积的雪速度是 0，不动)
+            sp.x += s.vx * ahead;
+            sp.y += s.vy * ahead;
+            snapshot.sprites.push_back(sp);
+            continue;
+        }
 
-    pRenderTarget->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+        m_landedScratch.push_back({(uint32_t)edge, {sp, s.landTick}});
+        m_edgeCounts[edge]++;
+    }
 
-    for (const auto &s : m_snowflakes)
+    // 计数排序：同一条表面上的雪排在一起
+    uint32_t first = 0;
+    for (size_t e = 0; e < edges.size(); ++e)
     {
-        if (s.size > 0.1f)
+        uint32_t count = m_edgeCounts[e];
+        if (count > 0)
         {
-            // ̬͸
-            float opacity = 0.8f;
-            if (s.landed)
-                opacity *= s.life;
-
-            // --- Ĳ죺 FillEllipse  DrawBitmap ---
-
-            // ĿΣ 32x32 ӡ£ŵ s.size С
-            // s.x, s.y ĵ
-            D2D1_RECT_F destRect = D2D1::RectF(
-                s.x - s.size, s.y - s.size, s.x + s.size, s.y + s.size);
-
-            // £
-            pRenderTarget->DrawBitmap(m_pSnowBitmap,
-                                      destRect,
-                                      opacity,
-                                      D2D1_BITMAP_INTERPOLATION_MODE_LINEAR,
-                                      NULL  // Դ NULL ʾʹλͼ
-            );
+            snapshot.layers.push_back(
+                {edges[e].left, edges[e].top, edges[e].right, first, count});
         }
+        m_edgeCounts[e] = first;
+        first += count;
     }
+
+    snapshot.landed.resize(m_landedScratch.size());
+    for (const auto &l : m_landedScratch)
+        snapshot.landed[m_edgeCounts[l.edge]++] = l.flake;
 }
 
-// ѩ
+// 调整雪花数量
 void SnowEngine::SetFlakeCount(int count)
 {
-    // һ·Χѵը
+    // 限制一下范围，别把电脑炸了 (紧凑存储每颗只占 16 字节，上限放宽)
+    int maxCount = m_bCompact ? 100000 : 5000;
     if (count < 0)
         count = 0;
-    if (count > 5000)
-        count = 5000;
+    if (count > maxCount)
+        count = maxCount;
 
-    int currentSize = (int)m_snowflakes.size();
+    int currentSize = (int)FlakeCount();
     if (count > currentSize)
     {
-        // Ҫӣ
-        for (int i = 0; i < count - currentSize; ++i)
+        // 需要增加：补足差额，新雪花直接批量生成在屏幕上方
+        size_t n = count - currentSize;
+        m_spawnScratch.resize(n);
+        SpawnSnowflakes(
+            m_spawnScratch.data(), n, m_screenWidth, -50.0f, -10.0f);
+
+        if (!m_bCompact)
         {
-            Snowflake s;
-            // λã֮ Reset 
-            s.x      = 0;
-            s.y      = -10.0f;
-            s.landed = false;
-            s.life   = 0.0f;  // Ϊ0
-            m_snowflakes.push_back(s);
+            m_snowflakes.insert(
+                m_snowflakes.end(), m_spawnScratch.begin(), m_spawnScratch.end());
+        }
+        else
+        {
+            m_compact.resize(count);
+            for (size_t i = 0; i < n; ++i)
+                m_codec.Encode(m_spawnScratch[i], m_compact[currentSize + i], 0.5f);
         }
     }
     else if (count < currentSize)
     {
-        // Ҫ٣ֱӽض
+        // 需要减少：雪花是按屏幕格子排好序的，直接截断会只删掉右下角的雪，
+        // 所以先随机挑出要删的换到末尾，再截断
+        for (int i = currentSize - 1; i >= count; --i)
+        {
+            std::uniform_int_distribution<int> pick(0, i);
+            int                                j = pick(m_rng);
+            if (!m_bCompact)
+                std::swap(m_snowflakes[i], m_snowflakes[j]);
+            else
+                std::swap(m_compact[i], m_compact[j]);
+        }
+
+        if (!m_bCompact)
+            m_snowflakes.resize(count);
+        else
+            m_compact.resize(count);
+    }
+}
+
+// 切换存储格式：现有的雪花原样转过去 (紧凑格式有量化误差，肉眼看不出来)
+void SnowEngine::SetCompactStorage(bool compact)
+{
+    if (compact == m_bCompact)
+        return;
+
+    m_bCompact = compact;
+    m_respawnQueue.clear();
+
+    if (compact)
+    {
+        UpdateCompactTile();
+        m_compact.resize(m_snowflakes.size());
+        for (size_t i = 0; i < m_snowflakes.size(); ++i)
+            m_codec.Encode(m_snowflakes[i], m_compact[i], 0.5f);
+
+        // 完整格式的内存还给系统，不然省内存就无从谈起
+        m_snowflakes.clear();
+        m_snowflakes.shrink_to_fit();
+    }
+    else
+    {
+        // 切回完整格式时，数量回到完整格式的上限以内
+        if (m_compact.size() > 5000)
+            m_compact.resize(5000);
+
+        m_snowflakes.resize(m_compact.size());
+        for (size_t i = 0; i < m_compact.size(); ++i)
+            m_codec.Decode(m_compact[i], m_snowflakes[i]);
+
+        m_compact.clear();
+        m_compact.shrink_to_fit();
+        m_compactScratch.clear();
+        m_compactScratch.shrink_to_fit();
+    }
+}
+
+// ---------------------------------------------------------
+//  存档 / 读档
+// ---------------------------------------------------------
+
+void SnowEngine::SaveState(std::vector<uint8_t> &out) const
+{
+    // 随机数发生器的状态只有文本格式是标准规定好的
+    std::ostringstream rng;
+    rng << m_rng;
+    std::string rngText = rng.str();
+
+    const void *flakes    = m_bCompact ? (const void *)m_compact.data()
+                                       : (const void *)m_snowflakes.data();
+    uint32_t    flakeSize = m_bCompact ? (uint32_t)sizeof(CompactFlake)
+                                       : (uint32_t)sizeof(Snowflake);
+    size_t      count     = FlakeCount();
+    size_t      payload   = rngText.size() + count * flakeSize;
+
+    SnowStateHeader header = {};
+    memcpy(header.magic, "SNOW", 4);
+    header.version      = SNOW_STATE_VERSION;
+    header.headerSize   = sizeof(SnowStateHeader);
+    header.flakeSize    = flakeSize;
+    header.flags        = m_bCompact ? STATE_FLAG_COMPACT : 0;
+    header.flakeCount   = (uint32_t)count;
+    header.screenWidth  = m_screenWidth;
+    header.screenHeight = m_screenHeight;
+    header.tick         = m_tick;
+    header.speedFactor  = m_speedFactor;
+    header.windForce    = m_windForce;
+    header.turbulence   = m_windField.Turbulence();
+    header.rngSize      = (uint32_t)rngText.size();
+
+    out.resize(sizeof(header) + payload);
+    uint8_t *p = out.data() + sizeof(header);
+    memcpy(p, rngText.data(), rngText.size());
+    if (count > 0)
+        memcpy(p + rngText.size(), flakes, count * flakeSize);
+
+    // landed 后面有 3 个编译器补的空字节，内容是随机的，原样写出去的话
+    // 同样的状态每次存出来都不一样 (校验和也跟着变)，写完统一清零
+    if (!m_bCompact)
+    {
+        const size_t padBegin = offsetof(Snowflake, landed) + sizeof(bool);
+        const size_t padEnd   = offsetof(Snowflake, landTick);
+        uint8_t     *dst      = p + rngText.size();
+        for (size_t i = 0; i < count; ++i, dst += sizeof(Snowflake))
+            memset(dst + padBegin, 0, padEnd - padBegin);
+    }
+
+    header.checksum = StateChecksum(p, payload);
+    memcpy(out.data(), &header, sizeof(header));
+}
+
+bool SnowEngine::LoadState(const void *data,
+                           size_t      size,
+                           int         screenWidth,
+                           int         screenHeight)
+{
+    if (size < sizeof(SnowStateHeader))
+        return false;
+
+    // 映射进来的文件不保证对齐，头先拷出来再看
+    SnowStateHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    bool     compact   = (header.flags & STATE_FLAG_COMPACT) != 0;
+    uint32_t flakeSize = compact ? (uint32_t)sizeof(CompactFlake)
+                                 : (uint32_t)sizeof(Snowflake);
+    uint32_t maxCount  = compact ? 100000 : 5000;
+
+    if (memcmp(header.magic, "SNOW", 4) != 0 ||
+        header.version != SNOW_STATE_VERSION ||
+        header.headerSize != sizeof(SnowStateHeader) ||
+        header.flakeSize != flakeSize || header.flakeCount > maxCount)
+        return false;
+
+    // 换了分辨率，存下来的位置、堆积的表面都没意义了
+    if (header.screenWidth != screenWidth ||
+        header.screenHeight != screenHeight)
+        return false;
+
+    size_t payload =
+        (size_t)header.rngSize + (size_t)header.flakeCount * flakeSize;
+    if (size != sizeof(header) + payload)
+        return false;
+
+    const uint8_t *p = (const uint8_t *)data + sizeof(header);
+    if (StateChecksum(p, payload) != header.checksum)
+        return false;
+
+    std::mt19937       rng;
+    std::istringstream rngText(std::string((const char *)p, header.rngSize));
+    rngText >> rng;
+    if (rngText.fail())
+        return false;
+
+    // 校验都过了才开始改引擎
+    const uint8_t *flakes = p + header.rngSize;
+    size_t         count  = header.flakeCount;
+
+    m_screenWidth  = screenWidth;
+    m_screenHeight = screenHeight;
+    m_tick         = header.tick;
+    m_rng          = rng;
+    m_bCompact     = compact;
+
+    if (!compact)
+    {
         m_snowflakes.resize(count);
+        if (count > 0)
+            memcpy(m_snowflakes.data(), flakes, count * flakeSize);
+        m_compact.clear();
+        m_compact.shrink_to_fit();
+        m_compactScratch.clear();
+    }
+    else
+    {
+        // 定点坐标是按存档时的屏幕大小编的，屏幕大小一样 tile 也一样
+        m_compact.clear();
+        m_codec = FlakeCodec();
+        UpdateCompactTile();
+        m_codec.SetTick(m_tick);
+        m_compact.resize(count);
+        if (count > 0)
+            memcpy(m_compact.data(), flakes, count * flakeSize);
+        m_snowflakes.clear();
+        m_snowflakes.shrink_to_fit();
     }
+
+    SetGravity(header.speedFactor);
+    SetWind(header.windForce);
+    SetTurbulence(header.turbulence);
+
+    // 堆积的雪下一帧要按当前的障碍物重新检查一遍脚下
+    m_landedCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Snowflake s;
+        FlakeAt((uint32_t)i, s);
+        m_landedCount += s.landed ? 1 : 0;
+    }
+
+    // 上一帧的障碍物清掉：下一帧按当前的窗口重建表面、重新检测
+    // (SetGravity 已经让所有雪花的着陆预测作废)
+    m_respawnQueue.clear();
+    m_lastObstacles.clear();
+    return true;
 }
 
-// ѩ½ٶȣ
-void SnowEngine::SetGravity(float g) { m_speedFactor = g; }
+// 调整雪花重力（下降速度）
+void SnowEngine::SetGravity(float g)
+{
+    m_speedFactor       = g;
+    m_bHitParamsChanged = true;
+}
 
-// ѩƮ
+// 调整雪花风力（左右飘动）
 void SnowEngine::SetWind(float w) { m_windForce = w; }
+
+// 调整湍流强度（0 = 只有全局风）
+void SnowEngine::SetTurbulence(float t)
+{
+    m_windField.SetTurbulence(t);
+    m_bHitParamsChanged = true;
+}
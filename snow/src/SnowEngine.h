@@ -1,67 +1,243 @@
 #pragma once
 #include <vector>
-#include <d2d1.h>
-#include "WindowUtils.h"
+#include <random>
+#include <cstdint>
+#include "WindowSource.h"
+#include "Snowflake.h"
+#include "WindField.h"
+#include "FlakeGrid.h"
+#include "CompactFlake.h"
+#include "SnowSnapshot.h"
+#include "SurfaceEdges.h"
+#include "ObstacleDiff.h"
 
-// 1. ѩȻǼ򵥵 struct ()
-struct Snowflake
-{
-    float x;
-    float y;
-    float speed;
-    float size;
-    float angle;    // ҡ
-    bool  landed;   // Ƿ½
-    float life;     // ѻ (1.0 -> 0.0)
-    float maxSize;  // סԭĴСڻʱ
-};
-
-// 2.  (߼)
+// 2. 引擎类 (逻辑)
 class SnowEngine
 {
   public:
     SnowEngine();
     ~SnowEngine();
 
-    // ʼĻС
-    void Initialize(int screenWidth, int screenHeight);
+    // 指定种子：同样的种子、参数和输入，每一帧的结果都一模一样 (离线导出用)
+    explicit SnowEngine(uint32_t seed);
 
-    // £ĻСӦԷֱʸı䣩
+    // 初始化：传入屏幕大小 (count 默认 1000 片，开场一次性批量生成)
+    void Initialize(int screenWidth, int screenHeight, int count = 1000);
+
+    // 更新：传入屏幕大小（应对分辨率改变）
     void Update(int                          screenWidth,
                 int                          screenHeight,
                 const std::vector<Obstacle> &obstacles,
-                POINT                        mousePos);
+                const std::vector<POINT>    &mousePath);
+
+    // 渲染：把这一帧要画的雪花写进快照 (真正的绘制在渲染线程里)
+    // 只有剔除后看得见的雪花才会进快照
+    // ahead：显示帧率比模拟高时，这一帧离上一步模拟过了几分之几步，
+    // 下落的雪花按速度往前推这么多 (0 = 就画模拟的位置)
+    void BuildSnapshot(SnowSnapshot &snapshot, float ahead = 0.0f);
 
-    // Ⱦ Direct2D  RenderTarget ͻ
-    void Render(ID2D1HwndRenderTarget    *pRenderTarget,
-                ID2D1RadialGradientBrush *pBrush);
+    // 各个显示器在窗口坐标里的矩形 (空 = 整个虚拟屏幕都算看得见)
+    // 显示器之间的空隙 (多屏不一样高时) 里的雪花不画
+    void SetViewRects(const std::vector<RECT> &rects) { m_viewRects = rects; }
 
-    // Դ豸ʧʱҪλͼ
-    void DiscardDeviceResources();
+    // 完全藏在不积雪的窗口 (最大化窗口) 范围里的雪花也不画，默认关闭
+    // (覆盖窗口是置顶的，打开后雪只会下在桌面和普通窗口上)
+    void SetCullOccluded(bool cull) { m_bCullOccluded = cull; }
 
-    // ---  ---
+    // --- 新增参数控制 ---
     void SetFlakeCount(int count);
     void SetGravity(float gravity);
     void SetWind(float wind);
+    void SetTurbulence(float turbulence);
+
+    // 中景 / 远景的视差层 (不逐颗模拟，只滚动预先画好的平铺图)，默认关闭
+    void SetParallax(bool enable) { m_bParallax = enable; }
+
+    // 紧凑存储 (每颗 16 字节)：给几万到十万片的“暴风雪”用，默认关闭
+    // 打开后 SetFlakeCount 的上限从 5000 放宽到 100000
+    void SetCompactStorage(bool compact);
+
+    // --- 存档 (格式见 StateFile.h) ---
+    // 把整个模拟状态写成一份存档，下次启动 LoadState 直接接着下，不用重新撒雪
+    void SaveState(std::vector<uint8_t> &out) const;
+
+    // 从存档恢复：版本、大小、校验和或者屏幕大小有一样对不上就返回 false，
+    // 引擎保持原样 (调用方照常 Initialize)
+    bool LoadState(const void *data, size_t size, int screenWidth, int screenHeight);
+
+    // 读档以后界面上的滑块要跟着对齐
+    float Gravity() const { return m_speedFactor; }
+    float Wind() const { return m_windForce; }
+    float Turbulence() const { return m_windField.Turbulence(); }
+
+    size_t FlakeCount() const
+    {
+        return m_bCompact ? m_compact.size() : m_snowflakes.size();
+    }
+
+    // 上一帧结束时堆积着的雪 / 上一份快照里看得见的雪
+    size_t LandedCount() const { return m_landedCount; }
+    size_t VisibleCount() const { return m_visible.size(); }
 
   private:
-    std::vector<Snowflake> m_snowflakes;  // ѩ
+    std::vector<Snowflake> m_snowflakes;  // 这里管理所有雪花
+
+    // 紧凑存储模式下雪花放在这里 (m_snowflakes 为空)
+    bool                      m_bCompact = false;
+    std::vector<CompactFlake> m_compact;
+    std::vector<CompactFlake> m_compactScratch;  // 排序用的交替缓冲
+    FlakeCodec                m_codec;
+
+    // 帧计数 (融化计时、紧凑存储的随机舍入都靠它)
+    uint32_t m_tick = 0;
+
+    float m_speedFactor = 1.0f;  // 默认 1.0
+    float m_windForce   = 0.0f;  // 默认 0.0
+
+    // 记住最近一次的屏幕大小，SetFlakeCount 补雪时要用
+    int m_screenWidth  = 0;
+    int m_screenHeight = 0;
+
+    // 引擎自己的随机数发生器 (只负责给每一批生成任务发种子)
+    std::mt19937 m_rng;
+
+    // 视差层：每层只有一个滚动偏移量
+    bool           m_bParallax = false;
+    ParallaxOffset m_parallax[PARALLAX_LAYER_COUNT] = {};
+
+    // 视差层跟着重力和风滚一步
+    void AdvanceParallax(float windX);
+
+    // 风场：阵风 + 湍流 (预计算的旋度噪声纹理，每颗雪花查一次表)
+    WindField m_windField;
+
+    // 雪花的均匀网格：每帧开头按屏幕格子给 m_snowflakes 排序，
+    // 所有空间查询 (鼠标等) 都通过它只看附近的格子
+    FlakeGrid m_grid;
+
+    // 上一帧结束时有多少颗堆积的雪 (为 0 时跳过整个堆积分支)
+    size_t m_landedCount = 0;
+
+    // 着陆后多少帧化完 (以前是每帧 life -= 0.005)
+    static const uint32_t MELT_TICKS = 200;
+
+    // 堆积的雪的剩余寿命 (1.0 -> 0.0)，由着陆帧号现算
+    float MeltLife(uint32_t landTick) const
+    {
+        return 1.0f - (float)(m_tick - landTick) * (1.0f / MELT_TICKS);
+    }
+
+    // 上一帧的障碍物：没变的话堆积的雪不用重新检查脚下
+    std::vector<Obstacle> m_lastObstacles;
+    bool                  m_bObstaclesChanged = true;
+
+    // 障碍物变了的时候，和上一次比出具体哪些窗口挪了 (按窗口 id 认)
+    ObstacleDiffer m_obstacleDiffer;
+    ObstacleDiff   m_obstacleDiff;
+
+    // 窗口挪了：堆在它顶边上的雪跟着平移 (要在重建表面之前，按旧的表面认)
+    // 挪过去以后照常检查脚下，被别的窗口盖住的还是会掉下来
+    void CarryLandedSnow();
+
+    // 事件驱动的碰撞：每颗下落的雪花记着“最早哪一帧可能着陆” (hitTick)，
+    // 不到那一帧就完全不看障碍物
+    bool m_bRescheduleHits   = true;   // 这一帧所有雪花都要重新检测、重新预测
+    bool m_bHitParamsChanged = false;  // 重力/湍流改过 (预测用的速度上限变了)
+
+    uint32_t PredictHitTick(const Snowflake &s) const;
+
+    // 露在外面的可积雪表面 (障碍物变了才重建)，着陆检测和预测都查它
+    SurfaceEdges m_surfaces;
+
+    // --- 可见性剔除 (BuildSnapshot 用) ---
+    std::vector<RECT>     m_viewRects;
+    bool                  m_bCullOccluded = false;
+    std::vector<uint32_t> m_visible;  // 这一帧看得见的雪花下标 (紧凑排列)
+
+    // 按下标取一颗雪花 (紧凑存储时解码)
+    void FlakeAt(uint32_t i, Snowflake &s) const
+    {
+        if (!m_bCompact)
+            s = m_snowflakes[i];
+        else
+            m_codec.Decode(m_compact[i], s);
+    }
+
+    // 一颗雪花画出来的样子 (位置、大小、透明度)
+    void SpriteOf(const Snowflake &s, FlakeSprite &sprite) const;
+
+    // 剔除：先按渲染目标裁掉，再按显示器 / 遮挡窗口筛一遍，结果在 m_visible
+    void CullSnowflakes();
+
+    // 障碍物变一次加一，随快照交给渲染线程 (堆积的雪的图层要重画)
+    uint32_t m_surfaceVersion = 0;
+
+    // 快照里按表面给堆积的雪分组用的临时缓冲
+    struct LandedOnEdge
+    {
+        uint32_t     edge;
+        LandedSprite flake;
+    };
+    std::vector<LandedOnEdge> m_landedScratch;
+    std::vector<uint32_t>     m_edgeCounts;
+
+    // 本帧需要重生的雪花下标，Update 末尾统一批量重生
+    std::vector<size_t> m_respawnQueue;
+
+    // 批量重生用的临时缓冲 (反复复用，避免每帧分配)
+    std::vector<Snowflake> m_spawnScratch;
+
+    // 批量生成 count 颗雪花的初始状态 (复用逻辑)
+    // y 在 [yMin, yMax] 之间均匀分布，数量很大时自动分块并行
+    void SpawnSnowflakes(Snowflake *out,
+                         size_t     count,
+                         int        screenWidth,
+                         float      yMin,
+                         float      yMax);
+
+    // 把 m_respawnQueue 里排队的雪花一次性重生
+    void FlushRespawnQueue(int screenWidth);
+
+    // 一颗雪花这一帧结束时的状态
+    enum StepResult
+    {
+        STEP_FALLING,
+        STEP_LANDED,
+        STEP_RESPAWN
+    };
+
+    // 每颗雪花的一步更新 (按这一帧的功能开关特化，见 SnowEngine.cpp)
+    template <bool kWind, bool kTurbulence, bool kObstacles, bool kLanded>
+    StepResult StepFlake(Snowflake                   &s,
+                         const std::vector<Obstacle> &obstacles,
+                         float                        windX) const;
 
-    float m_speedFactor = 1.0f;  // Ĭ 1.0
-    float m_windForce   = 0.0f;  // Ĭ 0.0
+    template <bool kWind, bool kTurbulence, bool kObstacles, bool kLanded>
+    void StepSnowflakes(const std::vector<Obstacle> &obstacles, float gust);
 
-    // ѩλͼ
-    ID2D1Bitmap *m_pSnowBitmap = nullptr;
+    // 按下标修改一颗雪花，两种存储格式通用
+    // (紧凑存储时先解码，改完再四舍五入编码回去)
+    template <typename Fn>
+    void VisitFlake(uint32_t i, Fn &&fn)
+    {
+        if (!m_bCompact)
+        {
+            fn(m_snowflakes[i]);
+            return;
+        }
 
-    // ȷֲ
-    float RandomFloat(float min, float max);
+        Snowflake s;
+        m_codec.Decode(m_compact[i], s);
+        fn(s);
+        m_codec.EncodeState(s, m_compact[i], 0.5f);
+    }
 
-    // ֲ̬
-    float RandomNormal(float mean, float stddev);
+    // 紧凑存储的定点坐标范围跟着屏幕大小走
+    void UpdateCompactTile();
 
-    // õѩĺ(߼)
-    void ResetSnowflake(Snowflake &s, int screenWidth, int screenHeight);
+    // 按屏幕格子给雪花重新排序 (m_snowflakes 的下标会变)
+    void BinSnowflakes();
 
-    // ڲĸͼƬ
-    void CreateSnowBitmap(ID2D1HwndRenderTarget *pRenderTarget);
+    // 鼠标斥力：沿着本帧的鼠标轨迹 (一串线段组成的胶囊体) 推开雪花
+    void ApplyMouseForce(const std::vector<POINT> &mousePath);
 };
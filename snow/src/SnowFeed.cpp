@@ -0,0 +1,349 @@
+#include "SnowFeed.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+static const char DEFAULT_NAME[] = "Local\\SnowFeed";
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+static const char DEFAULT_NAME[] = "/snow-feed";
+#endif
+
+// ---------------------------------------------------------
+//  共享内存
+// ---------------------------------------------------------
+
+#ifdef _WIN32
+
+bool SharedMemory::Create(const char *name, size_t size)
+{
+    Close();
+
+    HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE,
+                                         nullptr,
+                                         PAGE_READWRITE,
+                                         (DWORD)((uint64_t)size >> 32),
+                                         (DWORD)size,
+                                         name);
+    if (!hMapping)
+        return false;
+
+    m_pData = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!m_pData)
+    {
+        CloseHandle(hMapping);
+        return false;
+    }
+
+    m_hMapping = hMapping;
+    m_size     = size;
+    m_owner    = true;
+    return true;
+}
+
+bool SharedMemory::Open(const char *name)
+{
+    Close();
+
+    HANDLE hMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!hMapping)
+        return false;
+
+    m_pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_pData)
+    {
+        CloseHandle(hMapping);
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(m_pData, &info, sizeof(info));
+
+    m_hMapping = hMapping;
+    m_size     = info.RegionSize;
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    if (m_pData)
+        UnmapViewOfFile(m_pData);
+    if (m_hMapping)
+        CloseHandle((HANDLE)m_hMapping);
+
+    m_pData    = nullptr;
+    m_hMapping = nullptr;
+    m_size     = 0;
+    m_owner    = false;
+}
+
+#else
+
+bool SharedMemory::Create(const char *name, size_t size)
+{
+    Close();
+
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return false;
+    }
+
+    m_pData = p;
+    m_size  = size;
+    m_owner = true;
+    strncpy(m_name, name, sizeof(m_name) - 1);
+    return true;
+}
+
+bool SharedMemory::Open(const char *name)
+{
+    Close();
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+
+    m_pData = p;
+    m_size  = (size_t)st.st_size;
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    if (m_pData)
+        munmap(m_pData, m_size);
+    if (m_owner)
+        shm_unlink(m_name);
+
+    m_pData = nullptr;
+    m_size  = 0;
+    m_owner = false;
+}
+
+#endif
+
+// ---------------------------------------------------------
+//  发布端
+// ---------------------------------------------------------
+
+static inline SnowFeedSlotHeader *SlotAt(SnowFeedHeader *pHeader,
+                                         uint64_t        frame)
+{
+    uint8_t *base = (uint8_t *)pHeader + sizeof(SnowFeedHeader);
+    return (SnowFeedSlotHeader *)(base + (frame % pHeader->slotCount) *
+                                             pHeader->slotStride);
+}
+
+bool SnowFeedWriter::Open(const char *name, uint32_t capacity, uint32_t slots)
+{
+    if (slots < 2)
+        slots = 2;
+
+    // 每块按 64 字节对齐 (块头里有 64 位的原子变量，也不和别的块挤一条缓存行)
+    size_t stride = sizeof(SnowFeedSlotHeader) +
+                    (size_t)capacity * sizeof(SnowFeedParticle);
+    stride        = (stride + 63) & ~(size_t)63;
+
+    size_t size = sizeof(SnowFeedHeader) + stride * slots;
+    if (!m_memory.Create(name ? name : DEFAULT_NAME, size))
+        return false;
+
+    // 同名的内存不一定是新建的：上一个写端崩了没来得及 shm_unlink，
+    // 或者 (Windows) 还有读端开着旧的映射，拿到的就是上次留下的内容
+    // 某一块的 seq 可能停在奇数 (写到一半死掉的)，接着往上加的话奇偶就反了：
+    // 读端永远丢掉那一块，却把写了一半的当成完整的
+    // 所以先撤掉 magic (新来的读端不认)，再把 latest 和每一块的头重置
+    m_pHeader = (SnowFeedHeader *)m_memory.Data();
+    memset(m_pHeader->magic, 0, sizeof(m_pHeader->magic));
+    m_pHeader->latest.store(0, std::memory_order_relaxed);
+
+    m_pHeader->version        = SNOW_FEED_VERSION;
+    m_pHeader->headerSize     = sizeof(SnowFeedHeader);
+    m_pHeader->slotHeaderSize = sizeof(SnowFeedSlotHeader);
+    m_pHeader->particleSize   = sizeof(SnowFeedParticle);
+    m_pHeader->slotCount      = slots;
+    m_pHeader->capacity       = capacity;
+    m_pHeader->slotStride     = (uint32_t)stride;
+
+    // seq 拨到比原来大的偶数，而不是清零：还挂在旧内容上的读端，
+    // 手里的 seq 和新的对不上，会丢掉重来
+    for (uint32_t i = 0; i < slots; ++i)
+    {
+        SnowFeedSlotHeader *pSlot = SlotAt(m_pHeader, i);
+        uint32_t            seq   = pSlot->seq.load(std::memory_order_relaxed);
+        pSlot->seq.store((seq | 1) + 1, std::memory_order_relaxed);
+        pSlot->count        = 0;
+        pSlot->truncated    = 0;
+        pSlot->tick         = 0;
+        pSlot->frame        = 0;
+        pSlot->screenWidth  = 0;
+        pSlot->screenHeight = 0;
+    }
+
+    // 头最后写 magic，读端看到 magic 时其他字段都已经填好了
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(m_pHeader->magic, "SNWF", 4);
+
+    m_frame = 0;
+    return true;
+}
+
+void SnowFeedWriter::Publish(const SnowSnapshot &snapshot)
+{
+    if (!m_pHeader)
+        return;
+
+    uint64_t            frame = ++m_frame;
+    SnowFeedSlotHeader *pSlot = SlotAt(m_pHeader, frame);
+
+    // 开始写：seq 变奇数，之后的写不能被排到它前面
+    uint32_t seq = pSlot->seq.load(std::memory_order_relaxed);
+    pSlot->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SnowFeedParticle *out      = (SnowFeedParticle *)(pSlot + 1);
+    uint32_t          capacity = m_pHeader->capacity;
+    uint32_t          count    = 0;
+
+    for (const auto &sprite : snapshot.sprites)
+    {
+        if (count == capacity)
+            break;
+        out[count++] = {sprite.x, sprite.y, sprite.size, sprite.opacity, 0};
+    }
+    for (const auto &landed : snapshot.landed)
+    {
+        if (count == capacity)
+            break;
+        const FlakeSprite &sprite = landed.sprite;
+        out[count++]              = {sprite.x,
+                                     sprite.y,
+                                     sprite.size,
+                                     sprite.opacity,
+                                     FEED_PARTICLE_LANDED};
+    }
+
+    size_t total = snapshot.sprites.size() + snapshot.landed.size();
+
+    pSlot->count        = count;
+    pSlot->truncated    = (uint32_t)(total - count);
+    pSlot->tick         = snapshot.tick;
+    pSlot->frame        = frame;
+    pSlot->screenWidth  = snapshot.screenWidth;
+    pSlot->screenHeight = snapshot.screenHeight;
+
+    // 写完：seq 变回偶数，再公布这是最新的一帧
+    pSlot->seq.store(seq + 2, std::memory_order_release);
+    m_pHeader->latest.store(frame, std::memory_order_release);
+}
+
+// ---------------------------------------------------------
+//  读取端
+// ---------------------------------------------------------
+
+bool SnowFeedReader::Open(const char *name)
+{
+    m_pHeader = nullptr;
+    if (!m_memory.Open(name ? name : DEFAULT_NAME))
+        return false;
+
+    // 布局对不上 (版本不同、写端还没初始化完) 就不认
+    auto *pHeader = (const SnowFeedHeader *)m_memory.Data();
+    if (m_memory.Size() < sizeof(SnowFeedHeader) ||
+        memcmp(pHeader->magic, "SNWF", 4) != 0)
+    {
+        Close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    size_t stride = sizeof(SnowFeedSlotHeader) +
+                    (size_t)pHeader->capacity * sizeof(SnowFeedParticle);
+    if (pHeader->version != SNOW_FEED_VERSION ||
+        pHeader->headerSize != sizeof(SnowFeedHeader) ||
+        pHeader->slotHeaderSize != sizeof(SnowFeedSlotHeader) ||
+        pHeader->particleSize != sizeof(SnowFeedParticle) ||
+        pHeader->slotCount == 0 || pHeader->slotStride < stride ||
+        m_memory.Size() < sizeof(SnowFeedHeader) +
+                              (size_t)pHeader->slotStride * pHeader->slotCount)
+    {
+        Close();
+        return false;
+    }
+
+    m_pHeader = pHeader;
+    return true;
+}
+
+bool SnowFeedReader::BeginRead(const SnowFeedSlotHeader *&pSlot,
+                               uint32_t                  &seq) const
+{
+    if (!m_pHeader)
+        return false;
+
+    for (int spin = 0; spin < 64; ++spin)
+    {
+        uint64_t frame = m_pHeader->latest.load(std::memory_order_acquire);
+        if (frame == 0)
+            return false;
+
+        pSlot = SlotAt((SnowFeedHeader *)m_pHeader, frame);
+        seq   = pSlot->seq.load(std::memory_order_acquire);
+        if ((seq & 1) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool SnowFeedReader::EndRead(const SnowFeedSlotHeader *pSlot,
+                             uint32_t                  seq) const
+{
+    // 读数据的操作不能被排到这次读 seq 后面
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return pSlot->seq.load(std::memory_order_relaxed) == seq;
+}
+
+bool SnowFeedReader::Read(SnowFeedSlotHeader            &info,
+                          std::vector<SnowFeedParticle> &out) const
+{
+    return Peek([&](const SnowFeedSlotHeader &slot,
+                    const SnowFeedParticle   *particles,
+                    uint32_t                  count) {
+        info.count        = count;
+        info.truncated    = slot.truncated;
+        info.tick         = slot.tick;
+        info.frame        = slot.frame;
+        info.screenWidth  = slot.screenWidth;
+        info.screenHeight = slot.screenHeight;
+        out.assign(particles, particles + count);
+    });
+}
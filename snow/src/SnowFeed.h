@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "SnowSnapshot.h"
+
+// 共享内存的雪花数据 (默认不开，命令行加 --feed 才发布)
+// 别的程序 (动态壁纸、直播叠加层……) 直接映射同一块内存，按同一份快照画雪，
+// 不用走管道，也不用拷贝。Windows 上是 Local\SnowFeed，其他平台是
+// shm_open("/snow-feed")
+//
+// 布局 (版本 1，所有整数都是小端)：
+//   SnowFeedHeader                      64 字节
+//   SnowFeedSlot × slotCount            每块 slotStride 字节：
+//     SnowFeedSlotHeader                32 字节
+//     SnowFeedParticle × capacity       每颗 20 字节
+//
+// 每一帧写进下一块 (frame % slotCount)，写的时候那一块的 seq 是奇数，
+// 写完变成偶数，再把 header.latest 改成这一帧的帧号 (seqlock)
+// 读的一方：
+//   1. 读 latest，找到那一块
+//   2. 读 seq (acquire)，奇数说明正在写，重来
+//   3. 直接读里面的数据 (或者拷出来)
+//   4. 再读一次 seq，和第 2 步不一样说明读的时候被覆盖了，丢掉重来
+// 有好几块轮着写，读的一方一般不会和写的一方撞在同一块上
+// SnowFeedReader 就是照这个流程写的，自己实现读端也照着它来
+
+static const uint32_t SNOW_FEED_VERSION = 1;
+
+// 粒子的标志位
+static const uint32_t FEED_PARTICLE_LANDED = 1;  // 堆积在窗口上的雪
+
+struct SnowFeedParticle
+{
+    float    x;  // 中心点，覆盖窗口的坐标 (左上角 = 虚拟屏幕原点)
+    float    y;
+    float    size;  // 半径
+    float    opacity;
+    uint32_t flags;  // FEED_PARTICLE_*
+};
+
+struct SnowFeedHeader
+{
+    char     magic[4];  // "SNWF"
+    uint32_t version;   // SNOW_FEED_VERSION
+    uint32_t headerSize;
+    uint32_t slotHeaderSize;
+    uint32_t particleSize;
+    uint32_t slotCount;
+    uint32_t capacity;  // 每块最多几颗粒子
+    uint32_t slotStride;
+
+    std::atomic<uint64_t> latest;  // 最近写完的一帧的帧号 (0 = 还没有)
+
+    uint8_t reserved[24];
+};
+
+struct SnowFeedSlotHeader
+{
+    std::atomic<uint32_t> seq;  // 奇数 = 正在写
+
+    uint32_t count;      // 这一帧有几颗 (超过 capacity 的丢掉，见 truncated)
+    uint32_t truncated;  // 丢掉了几颗
+    uint32_t tick;       // 模拟的帧号
+    uint64_t frame;      // 发布的帧号 (和 latest 对应)
+    int32_t  screenWidth;
+    int32_t  screenHeight;
+};
+
+static_assert(sizeof(SnowFeedHeader) == 64, "feed layout changed");
+static_assert(sizeof(SnowFeedSlotHeader) == 32, "feed layout changed");
+static_assert(sizeof(SnowFeedParticle) == 20, "feed layout changed");
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "seqlock needs address-free atomics");
+
+// 映射一块有名字的共享内存 (写端创建，读端打开)
+class SharedMemory
+{
+  public:
+    SharedMemory() = default;
+    ~SharedMemory() { Close(); }
+
+    SharedMemory(const SharedMemory &)            = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+
+    bool Create(const char *name, size_t size);
+    bool Open(const char *name);
+    void Close();
+
+    void  *Data() const { return m_pData; }
+    size_t Size() const { return m_size; }
+
+  private:
+    void  *m_pData = nullptr;
+    size_t m_size  = 0;
+    bool   m_owner = false;  // POSIX：创建的一方关闭时 shm_unlink
+
+#ifdef _WIN32
+    void *m_hMapping = nullptr;  // HANDLE
+#else
+    char m_name[64] = {};
+#endif
+};
+
+// 发布端：模拟线程每帧调一次 Publish
+class SnowFeedWriter
+{
+  public:
+    static const uint32_t DEFAULT_SLOTS    = 4;
+    static const uint32_t DEFAULT_CAPACITY = 100000;  // 紧凑存储的上限
+
+    // name 传 nullptr 用默认的
+    bool Open(const char *name     = nullptr,
+              uint32_t    capacity = DEFAULT_CAPACITY,
+              uint32_t    slots    = DEFAULT_SLOTS);
+    void Close() { m_memory.Close(); }
+    bool IsOpen() const { return m_memory.Data() != nullptr; }
+
+    // 下落的雪花 + 堆积的雪一起发出去
+    void Publish(const SnowSnapshot &snapshot);
+
+  private:
+    SharedMemory    m_memory;
+    SnowFeedHeader *m_pHeader = nullptr;
+    uint64_t        m_frame   = 0;
+};
+
+// 读取端 (给别的程序用，只依赖这一对文件)
+class SnowFeedReader
+{
+  public:
+    bool Open(const char *name = nullptr);
+    void Close() { m_memory.Close(); }
+
+    // 零拷贝：最新一帧的粒子直接交给 visit(header, particles, count)，
+    // visit 返回以后再确认这段时间没被覆盖，被覆盖了就换最新的一帧重来
+    // visit 里看到的数据可能是写了一半的，确认之前不要拿它做不可撤销的事
+    // 返回 false：还没有帧，或者重试 maxRetries 次都没读到完整的
+    template <typename Visit>
+    bool Peek(Visit &&visit, int maxRetries = 8) const
+    {
+        for (int attempt = 0; attempt < maxRetries; ++attempt)
+        {
+            const SnowFeedSlotHeader *pSlot;
+            uint32_t                  seq;
+            if (!BeginRead(pSlot, seq))
+                return false;
+
+            // count 也可能正被改写，先限制在容量以内，不会读出界
+            uint32_t count = pSlot->count;
+            count = count < m_pHeader->capacity ? count : m_pHeader->capacity;
+            visit(*pSlot, Particles(pSlot), count);
+
+            if (EndRead(pSlot, seq))
+                return true;
+        }
+        return false;
+    }
+
+    // 拷出来一份完整的最新帧
+    bool Read(SnowFeedSlotHeader            &info,
+              std::vector<SnowFeedParticle> &out) const;
+
+  private:
+    // 找到最新的一块，读到一个偶数的 seq 为止
+    bool BeginRead(const SnowFeedSlotHeader *&pSlot, uint32_t &seq) const;
+    bool EndRead(const SnowFeedSlotHeader *pSlot, uint32_t seq) const;
+
+    const SnowFeedParticle *Particles(const SnowFeedSlotHeader *pSlot) const
+    {
+        return (const SnowFeedParticle *)(pSlot + 1);
+    }
+
+    SharedMemory          m_memory;
+    const SnowFeedHeader *m_pHeader = nullptr;
+};
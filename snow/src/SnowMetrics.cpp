@@ -0,0 +1,39 @@
+#include "SnowMetrics.h"
+#include <cstdio>
+
+void SnowMetrics::Format(std::string &out) const
+{
+    struct Entry
+    {
+        const char *name;
+        uint64_t    value;
+    };
+
+    const auto  r         = std::memory_order_relaxed;
+    const Entry entries[] = {
+        {"active_flakes", activeFlakes.load(r)},
+        {"landed_flakes", landedFlakes.load(r)},
+        {"visible_flakes", visibleFlakes.load(r)},
+        {"obstacles", obstacles.load(r)},
+        {"sim_us", simUs.load(r)},
+        {"snapshot_us", snapshotUs.load(r)},
+        {"render_us", renderUs.load(r)},
+        {"frames", frames.load(r)},
+        {"frames_drawn", framesDrawn.load(r)},
+        {"sim_steps", simSteps.load(r)},
+        {"missed_deadlines", missedDeadlines.load(r)},
+        {"dropped_snapshots", droppedSnapshots.load(r)},
+        {"allocations", allocations.load(r)},
+    };
+
+    char line[64];
+    for (const auto &e : entries)
+    {
+        snprintf(line,
+                 sizeof(line),
+                 "%s %llu\n",
+                 e.name,
+                 (unsigned long long)e.value);
+        out += line;
+    }
+}
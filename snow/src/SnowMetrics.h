@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 运行时的计数器，给本地的监控端点 (MetricsServer) 导出用
+// 热循环里只做 relaxed 的原子读写，不加锁；每个字段只有一个线程写
+// (注释里写了是谁)，导出线程随时读，最多读到上一帧的值
+struct SnowMetrics
+{
+    // --- 模拟 (UI 线程写) ---
+    std::atomic<uint32_t> activeFlakes{0};
+    std::atomic<uint32_t> landedFlakes{0};
+    std::atomic<uint32_t> visibleFlakes{0};  // 剔除后进了快照的
+    std::atomic<uint32_t> obstacles{0};
+
+    std::atomic<uint32_t> simUs{0};       // 最近一帧：模拟步 (含障碍物刷新)
+    std::atomic<uint32_t> snapshotUs{0};  // 最近一帧：剔除 + 写快照
+
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> simSteps{0};
+    std::atomic<uint64_t> missedDeadlines{0};   // FramePacer 跳过的帧
+    std::atomic<uint64_t> droppedSnapshots{0};  // 渲染线程没取走就被顶掉的
+
+    // 整个进程 operator new 的次数 (稳定以后每帧应该是 0)
+    // 每帧从 AllocCounter 抄过来；没链接 AllocCounter.cpp 的程序一直是 0
+    std::atomic<uint64_t> allocations{0};
+
+    // --- 渲染线程写 ---
+    std::atomic<uint32_t> renderUs{0};  // 最近一帧：画 + EndDraw
+    std::atomic<uint64_t> framesDrawn{0};
+
+    // 单写者的计数：分开读和写，不需要带锁的读-改-写指令
+    static void Add(std::atomic<uint64_t> &counter, uint64_t n = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n,
+                      std::memory_order_relaxed);
+    }
+
+    static void Set(std::atomic<uint32_t> &value, uint64_t v)
+    {
+        value.store((uint32_t)v, std::memory_order_relaxed);
+    }
+
+    // 导出成文本，每行 "名字 数值"
+    void Format(std::string &out) const;
+};
@@ -0,0 +1,511 @@
+#include "SnowPresenter.h"
+#include <chrono>
+#include <random>
+
+SnowPresenter::~SnowPresenter() { Stop(); }
+
+void SnowPresenter::Start(HWND hWnd)
+{
+    if (m_bRunning)
+        return;
+
+    m_hWnd        = hWnd;
+    m_hFrameEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!m_hFrameEvent)
+        return;
+
+    m_bRunning = true;
+    m_thread   = std::thread(&SnowPresenter::ThreadProc, this);
+}
+
+void SnowPresenter::Stop()
+{
+    if (!m_bRunning)
+        return;
+
+    // 叫醒渲染线程，让它自己收拾 Direct2D 资源后退出
+    m_bRunning = false;
+    SetEvent(m_hFrameEvent);
+    m_thread.join();
+
+    CloseHandle(m_hFrameEvent);
+    m_hFrameEvent = nullptr;
+}
+
+void SnowPresenter::Publish()
+{
+    bool dropped = m_snapshots.Publish();
+    if (dropped && m_pMetrics)
+        SnowMetrics::Add(m_pMetrics->droppedSnapshots);
+
+    // 渲染线程还在画上一帧的话，事件会一直亮着，画完马上取最新的
+    if (m_hFrameEvent)
+        SetEvent(m_hFrameEvent);
+}
+
+void SnowPresenter::ThreadProc()
+{
+    while (true)
+    {
+        WaitForSingleObject(m_hFrameEvent, INFINITE);
+        if (!m_bRunning)
+            break;
+
+        // 事件可能攒了好几次，只画最新的一份
+        if (!m_snapshots.Acquire())
+            continue;
+
+        const SnowSnapshot &snapshot = m_snapshots.ReadBuffer();
+
+        // 缩小倍数改了：所有资源 (图层、视差小图) 都按新的像素密度重建
+        if (m_pRenderTarget &&
+            m_requestedScale.load(std::memory_order_relaxed) != m_renderScale)
+            DiscardDeviceResources();
+
+        if (!m_pRenderTarget)
+        {
+            if (!CreateDeviceResources(snapshot.screenWidth,
+                                       snapshot.screenHeight))
+                continue;
+        }
+        else if (snapshot.screenWidth != m_targetWidth ||
+                 snapshot.screenHeight != m_targetHeight)
+        {
+            // 分辨率变了，渲染目标跟着变
+            m_targetWidth  = snapshot.screenWidth;
+            m_targetHeight = snapshot.screenHeight;
+            m_pRenderTarget->Resize(ScaledSize(m_targetWidth, m_targetHeight));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        m_pRenderTarget->BeginDraw();
+        m_pRenderTarget->Clear(D2D1::ColorF(0, 0, 0, 0));
+        Draw(snapshot);
+
+        HRESULT hr = m_pRenderTarget->EndDraw();
+
+        if (m_pMetrics)
+        {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+            SnowMetrics::Set(m_pMetrics->renderUs, us.count());
+            SnowMetrics::Add(m_pMetrics->framesDrawn);
+        }
+
+        // 设备丢失处理：显卡掉了，释放所有资源，下次重来
+        if (hr == D2DERR_RECREATE_TARGET)
+            DiscardDeviceResources();
+    }
+
+    DiscardDeviceResources();
+    if (m_pFactory)
+    {
+        m_pFactory->Release();
+        m_pFactory = nullptr;
+    }
+}
+
+bool SnowPresenter::CreateDeviceResources(int width, int height)
+{
+    // 工厂只有渲染线程用，单线程版就够了
+    if (!m_pFactory &&
+        FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED,
+                                 &m_pFactory)))
+        return false;
+
+    D2D1_PIXEL_FORMAT pixelFormat =
+        D2D1::PixelFormat(DXGI_FORMAT_UNKNOWN, D2D1_ALPHA_MODE_PREMULTIPLIED);
+
+    D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(
+        D2D1_RENDER_TARGET_TYPE_DEFAULT, pixelFormat);
+
+    // 渲染目标比窗口小的时候，Present 会把它拉伸到整个窗口 (只在合成时缩放一次)
+    m_renderScale = m_requestedScale.load(std::memory_order_relaxed);
+
+    if (FAILED(m_pFactory->CreateHwndRenderTarget(
+            props,
+            D2D1::HwndRenderTargetProperties(m_hWnd,
+                                             ScaledSize(width, height)),
+            &m_pRenderTarget)))
+        return false;
+
+    // 强制 DPI 为 96 (1:1 物理像素)；缩小时 DPI 跟着降，
+    // 画的时候照样用屏幕像素当坐标，离屏的图层、小图也自动按同样的密度建
+    float dpi = 96.0f / (float)m_renderScale;
+    m_pRenderTarget->SetDpi(dpi, dpi);
+    m_pRenderTarget->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+
+    m_targetWidth  = width;
+    m_targetHeight = height;
+
+    // 旧的 RenderTarget 没了，位图也要跟着重做
+    CreateSnowBitmap();
+    return m_pSnowBitmap != nullptr;
+}
+
+void SnowPresenter::DiscardDeviceResources()
+{
+    // 图层是从 RenderTarget 派生出来的，要先放掉
+    for (auto &cached : m_layers)
+        ReleaseLayer(cached);
+    m_layers.clear();
+    ReleaseParallaxTiles();
+
+    if (m_pSnowBitmap)
+    {
+        m_pSnowBitmap->Release();
+        m_pSnowBitmap = nullptr;
+    }
+    if (m_pRenderTarget)
+    {
+        m_pRenderTarget->Release();
+        m_pRenderTarget = nullptr;
+    }
+}
+
+// 创建“印章”
+void SnowPresenter::CreateSnowBitmap()
+{
+    // 1. 创建一个临时的“画布”，大小为 32x32
+    // 我们画一个高清晰度的雪花，然后渲染时缩放它，这样效果最好
+    ID2D1BitmapRenderTarget *pCompatibleRenderTarget = nullptr;
+    D2D1_SIZE_F              size = D2D1::SizeF(32.0f, 32.0f);
+
+    HRESULT hr = m_pRenderTarget->CreateCompatibleRenderTarget(
+        size, &pCompatibleRenderTarget);
+    if (FAILED(hr))
+        return;
+
+    // 2. 在临时画布上画一个完美的渐变雪花
+    pCompatibleRenderTarget->BeginDraw();
+    pCompatibleRenderTarget->Clear(D2D1::ColorF(0, 0, 0, 0));  // 透明背景
+
+    // 创建临时的渐变刷子
+    ID2D1RadialGradientBrush    *pTempBrush = nullptr;
+    ID2D1GradientStopCollection *pTempStops = nullptr;
+    D2D1_GRADIENT_STOP           stops[]    = {
+        {0.0f, D2D1::ColorF(D2D1::ColorF::White, 1.0f)},  // 中心白
+        {1.0f, D2D1::ColorF(D2D1::ColorF::White, 0.0f)}  // 边缘透
+    };
+
+    pCompatibleRenderTarget->CreateGradientStopCollection(
+        stops, 2, D2D1_GAMMA_2_2, D2D1_EXTEND_MODE_CLAMP, &pTempStops);
+
+    if (pTempStops)
+    {
+        pCompatibleRenderTarget->CreateRadialGradientBrush(
+            D2D1::RadialGradientBrushProperties(
+                D2D1::Point2F(16, 16), D2D1::Point2F(0, 0), 16, 16),
+            pTempStops,
+            &pTempBrush);
+    }
+
+    if (pTempBrush)
+    {
+        pCompatibleRenderTarget->FillEllipse(
+            D2D1::Ellipse(D2D1::Point2F(16, 16), 16, 16), pTempBrush);
+    }
+
+    pCompatibleRenderTarget->EndDraw();
+
+    // 3. 把画好的结果取出来，存成位图 (印章)
+    pCompatibleRenderTarget->GetBitmap(&m_pSnowBitmap);
+
+    // 4. 清理临时工具
+    if (pTempBrush)
+        pTempBrush->Release();
+    if (pTempStops)
+        pTempStops->Release();
+    pCompatibleRenderTarget->Release();
+}
+
+void SnowPresenter::Draw(const SnowSnapshot &snapshot)
+{
+    // 从远到近：视差层 -> 堆积的雪 -> 下落的雪花
+    DrawParallax(snapshot);
+    DrawLayers(snapshot);
+
+    for (const auto &sprite : snapshot.sprites)
+    {
+        // 计算目标矩形：把 32x32 的印章，缩放到 sprite.size 大小
+        // sprite.x, sprite.y 是中心点
+        D2D1_RECT_F destRect = D2D1::RectF(sprite.x - sprite.size,
+                                           sprite.y - sprite.size,
+                                           sprite.x + sprite.size,
+                                           sprite.y + sprite.size);
+
+        // 盖章！
+        m_pRenderTarget->DrawBitmap(m_pSnowBitmap,
+                                    destRect,
+                                    sprite.opacity,
+                                    D2D1_BITMAP_INTERPOLATION_MODE_LINEAR,
+                                    NULL  // 源矩形 NULL 表示使用整个位图
+        );
+    }
+}
+
+// ---------------------------------------------------------
+//  堆积的雪的图层
+// ---------------------------------------------------------
+
+void SnowPresenter::DrawLayers(const SnowSnapshot &snapshot)
+{
+    m_layersScratch.clear();
+
+    for (size_t n = 0; n < snapshot.layers.size(); ++n)
+    {
+        const SnowLayer &layer = snapshot.layers[n];
+
+        // 表面一般就几十条，直接线性找上一帧的同一张图层
+        SurfaceLayer cached;
+        bool         found = false;
+        for (auto &old : m_layers)
+        {
+            if (old.pTarget && old.left == layer.left &&
+                old.top == layer.top && old.right == layer.right)
+            {
+                cached      = old;
+                old.pTarget = nullptr;  // 被领走了
+                old.pBitmap = nullptr;
+                found       = true;
+                break;
+            }
+        }
+
+        if (!found && !CreateLayer(layer, cached))
+            continue;
+
+        bool full = !found ||
+                    cached.surfaceVersion != snapshot.surfaceVersion ||
+                    (int32_t)(snapshot.tick - cached.restampTick) >=
+                        (int32_t)RESTAMP_TICKS;
+        StampLayer(snapshot, layer, cached, full);
+
+        // 错开各张新图层下次重盖的帧，不要挤在同一帧
+        if (!found)
+            cached.restampTick = snapshot.tick - (uint32_t)(n % RESTAMP_TICKS);
+
+        // 1:1 贴上去
+        D2D1_SIZE_F size = cached.pBitmap->GetSize();
+        float       x    = layer.left - LAYER_MARGIN;
+        float       y    = layer.top - LAYER_MARGIN;
+        m_pRenderTarget->DrawBitmap(
+            cached.pBitmap,
+            D2D1::RectF(x, y, x + size.width, y + size.height),
+            1.0f,
+            D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR,
+            NULL);
+
+        m_layersScratch.push_back(cached);
+    }
+
+    // 这一帧没用到的 (表面挪走了、雪化完了) 放掉
+    for (auto &old : m_layers)
+        ReleaseLayer(old);
+
+    m_layers.swap(m_layersScratch);
+}
+
+bool SnowPresenter::CreateLayer(const SnowLayer &layer, SurfaceLayer &cached)
+{
+    cached.left  = layer.left;
+    cached.top   = layer.top;
+    cached.right = layer.right;
+
+    // 和主 RenderTarget 兼容的离屏画布，雪花位图可以直接拿来盖
+    D2D1_SIZE_F size = D2D1::SizeF(layer.right - layer.left + 2 * LAYER_MARGIN,
+                                   2 * LAYER_MARGIN);
+    if (FAILED(m_pRenderTarget->CreateCompatibleRenderTarget(size,
+                                                             &cached.pTarget)))
+    {
+        cached.pTarget = nullptr;
+        return false;
+    }
+
+    cached.pTarget->GetBitmap(&cached.pBitmap);
+    if (!cached.pBitmap)
+    {
+        ReleaseLayer(cached);
+        return false;
+    }
+    return true;
+}
+
+// full = 清掉整张重盖；否则只补盖上次之后新落下的
+void SnowPresenter::StampLayer(const SnowSnapshot &snapshot,
+                               const SnowLayer    &layer,
+                               SurfaceLayer       &cached,
+                               bool                full)
+{
+    const LandedSprite *begin = snapshot.landed.data() + layer.first;
+    const LandedSprite *end   = begin + layer.count;
+
+    if (!full)
+    {
+        // 没有新落下的就连 BeginDraw 都省了
+        bool fresh = false;
+        for (const LandedSprite *it = begin; it != end && !fresh; ++it)
+            fresh = (int32_t)(it->landTick - cached.stampedTick) > 0;
+
+        if (!fresh)
+        {
+            cached.stampedTick = snapshot.tick;
+            return;
+        }
+    }
+
+    float originX = layer.left - LAYER_MARGIN;
+    float originY = layer.top - LAYER_MARGIN;
+
+    cached.pTarget->BeginDraw();
+    if (full)
+        cached.pTarget->Clear(D2D1::ColorF(0, 0, 0, 0));
+
+    for (const LandedSprite *it = begin; it != end; ++it)
+    {
+        if (!full && (int32_t)(it->landTick - cached.stampedTick) <= 0)
+            continue;  // 已经盖过了
+
+        const FlakeSprite &sprite = it->sprite;
+        float              x      = sprite.x - originX;
+        float              y      = sprite.y - originY;
+        cached.pTarget->DrawBitmap(m_pSnowBitmap,
+                                   D2D1::RectF(x - sprite.size,
+                                               y - sprite.size,
+                                               x + sprite.size,
+                                               y + sprite.size),
+                                   sprite.opacity,
+                                   D2D1_BITMAP_INTERPOLATION_MODE_LINEAR,
+                                   NULL);
+    }
+    cached.pTarget->EndDraw();
+
+    cached.stampedTick = snapshot.tick;
+    if (full)
+    {
+        cached.restampTick    = snapshot.tick;
+        cached.surfaceVersion = snapshot.surfaceVersion;
+    }
+}
+
+void SnowPresenter::ReleaseLayer(SurfaceLayer &cached)
+{
+    if (cached.pBitmap)
+    {
+        cached.pBitmap->Release();
+        cached.pBitmap = nullptr;
+    }
+    if (cached.pTarget)
+    {
+        cached.pTarget->Release();
+        cached.pTarget = nullptr;
+    }
+}
+
+// ---------------------------------------------------------
+//  视差层
+// ---------------------------------------------------------
+
+bool SnowPresenter::CreateParallaxTiles()
+{
+    for (int l = 0; l < PARALLAX_LAYER_COUNT; ++l)
+    {
+        const ParallaxLayerDesc &desc = PARALLAX_LAYERS[l];
+        float                    tile = (float)desc.tileSize;
+
+        ID2D1BitmapRenderTarget *pTileTarget = nullptr;
+        if (FAILED(m_pRenderTarget->CreateCompatibleRenderTarget(
+                D2D1::SizeF(tile, tile), &pTileTarget)))
+            return false;
+
+        // 固定种子：设备丢了重画出来还是同一张
+        std::mt19937                          rng(20231224u + l);
+        std::uniform_real_distribution<float> pos(0.0f, tile);
+        std::uniform_real_distribution<float> size(desc.minSize, desc.maxSize);
+
+        pTileTarget->BeginDraw();
+        pTileTarget->Clear(D2D1::ColorF(0, 0, 0, 0));
+        for (int i = 0; i < desc.flakesPerTile; ++i)
+        {
+            float x = pos(rng);
+            float y = pos(rng);
+            float r = size(rng);
+
+            // 压在边上的雪花在对边再盖一次，平铺起来才没有接缝
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    float cx = x + dx * tile;
+                    float cy = y + dy * tile;
+                    if (cx + r < 0 || cx - r > tile || cy + r < 0 ||
+                        cy - r > tile)
+                        continue;
+
+                    pTileTarget->DrawBitmap(
+                        m_pSnowBitmap,
+                        D2D1::RectF(cx - r, cy - r, cx + r, cy + r),
+                        1.0f,
+                        D2D1_BITMAP_INTERPOLATION_MODE_LINEAR,
+                        NULL);
+                }
+            }
+        }
+        pTileTarget->EndDraw();
+
+        ID2D1Bitmap *pTile = nullptr;
+        pTileTarget->GetBitmap(&pTile);
+        pTileTarget->Release();
+        if (!pTile)
+            return false;
+
+        HRESULT hr = m_pRenderTarget->CreateBitmapBrush(
+            pTile,
+            D2D1::BitmapBrushProperties(D2D1_EXTEND_MODE_WRAP,
+                                        D2D1_EXTEND_MODE_WRAP,
+                                        D2D1_BITMAP_INTERPOLATION_MODE_LINEAR),
+            &m_pParallaxBrushes[l]);
+        pTile->Release();  // 刷子自己会留一份引用
+        if (FAILED(hr))
+            return false;
+
+        m_pParallaxBrushes[l]->SetOpacity(desc.opacity);
+    }
+    return true;
+}
+
+void SnowPresenter::DrawParallax(const SnowSnapshot &snapshot)
+{
+    if (snapshot.parallaxLayers == 0)
+        return;
+
+    if (!m_pParallaxBrushes[0] && !CreateParallaxTiles())
+    {
+        ReleaseParallaxTiles();
+        return;
+    }
+
+    // 每层一次全屏填充，滚动只是改刷子的平移
+    D2D1_RECT_F screen =
+        D2D1::RectF(0, 0, (float)m_targetWidth, (float)m_targetHeight);
+    for (int l = 0; l < snapshot.parallaxLayers; ++l)
+    {
+        const ParallaxOffset &off = snapshot.parallax[l];
+        m_pParallaxBrushes[l]->SetTransform(
+            D2D1::Matrix3x2F::Translation(off.x, off.y));
+        m_pRenderTarget->FillRectangle(screen, m_pParallaxBrushes[l]);
+    }
+}
+
+void SnowPresenter::ReleaseParallaxTiles()
+{
+    for (auto &pBrush : m_pParallaxBrushes)
+    {
+        if (pBrush)
+        {
+            pBrush->Release();
+            pBrush = nullptr;
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <windows.h>
+#include <d2d1.h>
+#include <thread>
+#include <atomic>
+#include "SnowSnapshot.h"
+#include "SnowMetrics.h"
+
+#pragma comment(lib, "d2d1.lib")
+
+// 3. 渲染线程 (画面)
+// 模拟在 UI 线程上跑，每帧把结果写成一份快照交过来；
+// 这里的线程拿最新的快照画到覆盖窗口上。EndDraw 等垂直同步、
+// 显卡卡顿都只卡住这个线程，不会拖慢模拟和设置窗口
+// Direct2D 的所有资源都只在渲染线程里创建、使用和释放
+class SnowPresenter
+{
+  public:
+    SnowPresenter() = default;
+    ~SnowPresenter();
+
+    // 启动 / 停止渲染线程 (都在 UI 线程调用)
+    void Start(HWND hWnd);
+    void Stop();
+
+    // 模拟这一侧：先往 BeginFrame() 里写这一帧的快照，写完调用 Publish()
+    SnowSnapshot &BeginFrame() { return m_snapshots.WriteBuffer(); }
+    void          Publish();
+
+    // 计数器 (可以不设)：渲染耗时、画了几帧、被顶掉的快照
+    void SetMetrics(SnowMetrics *pMetrics) { m_pMetrics = pMetrics; }
+
+    // 降低内部分辨率：渲染目标的长宽都除以 divisor (1 = 原样，2 = 一半……)，
+    // 呈现时再整体拉伸到窗口大小。雪花本来就是软边的渐变，半分辨率看不出区别，
+    // 填充和清屏的像素却只剩 1/4。随时可以调 (UI 线程)，渲染线程下一帧重建资源
+    void SetRenderScale(int divisor)
+    {
+        if (divisor < 1)
+            divisor = 1;
+        if (divisor > MAX_RENDER_SCALE)
+            divisor = MAX_RENDER_SCALE;
+        m_requestedScale.store(divisor, std::memory_order_relaxed);
+    }
+
+    static const int MAX_RENDER_SCALE = 3;
+
+  private:
+    void ThreadProc();
+
+    // 设备资源：第一次画或者设备丢失后重新创建
+    bool CreateDeviceResources(int width, int height);
+    void DiscardDeviceResources();
+
+    // 内部函数：创建母版图片
+    void CreateSnowBitmap();
+
+    void Draw(const SnowSnapshot &snapshot);
+
+    // --- 堆积的雪：每条表面一张缓存的图层 ---
+    // 堆积的雪不会动，只会慢慢化掉。新落下的雪花只往图层上补盖一次，
+    // 每隔 RESTAMP_TICKS 帧整张清掉重盖一遍 (跟上融化进度、去掉化完的)，
+    // 平时每条表面只要贴一次图。表面挪了 (障碍物变了) 才重建
+    struct SurfaceLayer
+    {
+        float left;  // 认图层用：和 SnowLayer 的表面一样才算同一张
+        float top;
+        float right;
+
+        ID2D1BitmapRenderTarget *pTarget = nullptr;
+        ID2D1Bitmap             *pBitmap = nullptr;
+
+        uint32_t stampedTick    = 0;  // 这一帧 (含) 之前着陆的都盖上去了
+        uint32_t restampTick    = 0;  // 上次整张重盖的帧号
+        uint32_t surfaceVersion = 0;
+    };
+
+    // 融化 200 帧，10 帧重盖一次：大小和透明度最多差 5%
+    static const uint32_t RESTAMP_TICKS = 10;
+
+    // 图层比表面四周多留的边 (最大的雪花半径)
+    static constexpr float LAYER_MARGIN = 12.0f;
+
+    void DrawLayers(const SnowSnapshot &snapshot);
+    bool CreateLayer(const SnowLayer &layer, SurfaceLayer &cached);
+    void StampLayer(const SnowSnapshot &snapshot,
+                    const SnowLayer    &layer,
+                    SurfaceLayer       &cached,
+                    bool                full);
+    void ReleaseLayer(SurfaceLayer &cached);
+
+    std::vector<SurfaceLayer> m_layers;
+    std::vector<SurfaceLayer> m_layersScratch;
+
+    // --- 视差层：每层一张预先画好的平铺小图 + 平铺的位图刷子 ---
+    // 小图只在创建设备资源后画一次，之后每帧只改刷子的平移
+    bool CreateParallaxTiles();
+    void DrawParallax(const SnowSnapshot &snapshot);
+    void ReleaseParallaxTiles();
+
+    ID2D1BitmapBrush *m_pParallaxBrushes[PARALLAX_LAYER_COUNT] = {};
+
+    HWND              m_hWnd = nullptr;
+    std::thread       m_thread;
+    std::atomic<bool> m_bRunning{false};
+
+    // 有新快照时触发 (自动复位)，渲染线程平时就睡在它上面
+    HANDLE m_hFrameEvent = nullptr;
+
+    TripleBuffer<SnowSnapshot> m_snapshots;
+
+    SnowMetrics *m_pMetrics = nullptr;
+
+    // --- Direct2D (只在渲染线程里碰) ---
+    ID2D1Factory          *m_pFactory      = nullptr;
+    ID2D1HwndRenderTarget *m_pRenderTarget = nullptr;
+    ID2D1Bitmap           *m_pSnowBitmap   = nullptr;  // 缓存的雪花位图
+
+    // 渲染目标的逻辑大小 (屏幕像素)，画的时候都用这个坐标
+    int m_targetWidth  = 0;
+    int m_targetHeight = 0;
+
+    // 当前资源是按哪个缩小倍数建的 / UI 线程要求的倍数
+    int              m_renderScale = 1;
+    std::atomic<int> m_requestedScale{1};
+
+    // 屏幕像素 -> 渲染目标的物理像素 (向上取整，边上不留缝)
+    D2D1_SIZE_U ScaledSize(int width, int height) const
+    {
+        return D2D1::SizeU((width + m_renderScale - 1) / m_renderScale,
+                           (height + m_renderScale - 1) / m_renderScale);
+    }
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include "ParallaxLayers.h"
+
+// 渲染只需要知道“在哪、多大、多透明”，模拟的其余状态都不用带过去
+struct FlakeSprite
+{
+    float x;
+    float y;
+    float size;
+    float opacity;
+};
+
+// 堆积的雪：多带一个着陆帧号，渲染线程据此只补盖新落下的那几颗
+struct LandedSprite
+{
+    FlakeSprite sprite;
+    uint32_t    landTick;
+};
+
+// 一条露在外面的可积雪表面 (SurfaceEdge) 和堆在它上面的雪
+// 渲染线程按 (left, top, right) 认出同一条表面，给它缓存一张静态图层
+struct SnowLayer
+{
+    float left;
+    float top;
+    float right;
+
+    uint32_t first;  // 在 SnowSnapshot::landed 里的范围
+    uint32_t count;
+};
+
+// 某一帧模拟结果的快照：模拟线程写好以后就不再改，渲染线程只读
+struct SnowSnapshot
+{
+    std::vector<FlakeSprite> sprites;  // 正在下落的 (每帧都要画)
+
+    // 堆积的雪，按表面分好组 (画进各自的图层，不用每帧一颗颗画)
+    std::vector<LandedSprite> landed;
+    std::vector<SnowLayer>    layers;
+
+    // 视差层 (关掉时 parallaxLayers = 0)
+    int            parallaxLayers = 0;
+    ParallaxOffset parallax[PARALLAX_LAYER_COUNT];
+
+    uint32_t tick           = 0;  // 模拟的帧号
+    uint32_t surfaceVersion = 0;  // 障碍物变一次加一 (堆积的雪可能被挪动过)
+
+    int screenWidth  = 0;
+    int screenHeight = 0;
+};
+
+// 无锁三缓冲：一个生产者 (模拟) + 一个消费者 (渲染)，两边都不会等对方
+//   - 生产者永远写 back，写完 Publish 和 middle 对调
+//   - 消费者 Acquire 时如果 middle 是新的，就和 front 对调
+// 三块缓冲轮换使用，vector 的容量会留着，稳定以后不再分配内存
+// 渲染慢了只会跳过中间的帧，模拟慢了渲染就停在上一帧
+template <typename T>
+class TripleBuffer
+{
+  public:
+    // 生产者：当前可以写的缓冲
+    T &WriteBuffer() { return m_buffers[m_back]; }
+
+    // 生产者：写完了，交出去 (旧的 middle 如果没被取走，就回收来写下一帧)
+    // 返回 true 表示上一帧没被取走就被顶掉了 (渲染跟不上)
+    bool Publish()
+    {
+        uint8_t prev = m_middle.exchange(
+            (uint8_t)(m_back | FRESH_BIT), std::memory_order_acq_rel);
+        m_back = prev & INDEX_MASK;
+        return (prev & FRESH_BIT) != 0;
+    }
+
+    // 消费者：有新的一帧就换过来，返回 true；没有就继续用手上的
+    bool Acquire()
+    {
+        // 只有消费者会清掉 FRESH_BIT，所以这里先看一眼不会看错
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+
+        uint8_t prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front      = prev & INDEX_MASK;
+        return true;
+    }
+
+    // 消费者：当前可以读的缓冲 (直到下一次 Acquire 都不会被改)
+    const T &ReadBuffer() const { return m_buffers[m_front]; }
+
+  private:
+    static const uint8_t INDEX_MASK = 0x03;
+    static const uint8_t FRESH_BIT  = 0x04;
+
+    T m_buffers[3];
+
+    uint8_t              m_back   = 0;  // 只有生产者碰
+    uint8_t              m_front  = 1;  // 只有消费者碰
+    std::atomic<uint8_t> m_middle{2};   // 两边交换用 (低 2 位是下标)
+};
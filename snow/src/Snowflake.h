@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+// 1. 雪花依然是简单的 struct (数据)
+struct Snowflake
+{
+    float    x;
+    float    y;
+    float    vx;        // 速度 (像素/帧)，阻力会把它拉向空气的速度
+    float    vy;
+    float    speed;
+    float    size;
+    float    angle;     // 后面做摇摆用
+    bool     landed;    // 是否着陆
+    uint32_t landTick;  // 着陆的那一帧 (融化进度按它现算，不用每帧去减寿命)
+    uint32_t hitTick;   // 预测的最早可能碰到积雪表面的那一帧，之前不用做碰撞
+    float    maxSize;   // 记住它原本的大小，用于融化时缩放
+};
@@ -0,0 +1,167 @@
+#include "StateFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <string>
+#else
+#include <cstdio>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint32_t StateChecksum(const void *data, size_t size)
+{
+    const uint8_t *p    = (const uint8_t *)data;
+    uint32_t       hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const PathChar *path)
+{
+    Close();
+
+    HANDLE hFile = CreateFileW(path,
+                               GENERIC_READ,
+                               FILE_SHARE_READ,
+                               nullptr,
+                               OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL,
+                               nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+    m_hFile = hFile;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_hMapping =
+        CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_hMapping)
+    {
+        Close();
+        return false;
+    }
+
+    m_pData = MapViewOfFile((HANDLE)m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_pData)
+    {
+        Close();
+        return false;
+    }
+
+    m_size = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_pData)
+        UnmapViewOfFile(m_pData);
+    if (m_hMapping)
+        CloseHandle((HANDLE)m_hMapping);
+    if (m_hFile)
+        CloseHandle((HANDLE)m_hFile);
+
+    m_pData    = nullptr;
+    m_size     = 0;
+    m_hMapping = nullptr;
+    m_hFile    = nullptr;
+}
+
+bool WriteWholeFile(const PathChar *path, const void *data, size_t size)
+{
+    std::wstring temp = std::wstring(path) + L".tmp";
+
+    HANDLE hFile = CreateFileW(temp.c_str(),
+                               GENERIC_WRITE,
+                               0,
+                               nullptr,
+                               CREATE_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL,
+                               nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD written = 0;
+    BOOL  ok      = WriteFile(hFile, data, (DWORD)size, &written, nullptr) &&
+              written == (DWORD)size;
+    CloseHandle(hFile);
+
+    if (!ok || !MoveFileExW(temp.c_str(), path, MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool MappedFile::Open(const PathChar *path)
+{
+    Close();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // 映射建好以后 fd 就可以关了
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+
+    m_pData = p;
+    m_size  = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_pData)
+        munmap((void *)m_pData, m_size);
+    m_pData = nullptr;
+    m_size  = 0;
+}
+
+bool WriteWholeFile(const PathChar *path, const void *data, size_t size)
+{
+    std::string temp = std::string(path) + ".tmp";
+
+    FILE *f = fopen(temp.c_str(), "wb");
+    if (!f)
+        return false;
+
+    bool ok = fwrite(data, 1, size, f) == size;
+    ok      = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(temp.c_str(), path) != 0)
+    {
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "CompactFlake.h"
+
+// 引擎状态存档：退出或者睡眠前写一份，下次启动映射进来直接接着下
+// 格式：SnowStateHeader | 随机数发生器状态 (rngSize 字节) | 雪花数组
+// 雪花数组就是内存里的原样 (完整 44 字节或紧凑 16 字节一颗)，
+// 所以只认同一个版本、同样大小的结构体，对不上就当没有存档
+struct SnowStateHeader
+{
+    char     magic[4];    // "SNOW"
+    uint32_t version;     // SNOW_STATE_VERSION
+    uint32_t headerSize;  // sizeof(SnowStateHeader)
+    uint32_t flakeSize;   // 每颗雪花的字节数
+    uint32_t flags;       // STATE_FLAG_*
+    uint32_t flakeCount;
+
+    int32_t  screenWidth;  // 屏幕大小变了，存的位置就对不上了
+    int32_t  screenHeight;
+    uint32_t tick;
+
+    float speedFactor;
+    float windForce;
+    float turbulence;
+
+    uint32_t rngSize;
+    uint32_t checksum;  // 头后面所有数据的 FNV-1a
+};
+
+static const uint32_t SNOW_STATE_VERSION = 1;
+
+// 雪花是按内存原样存的，结构体布局一动旧存档就会读成乱码：
+// 这里过不去，说明改了 Snowflake / CompactFlake，先把上面的版本号加一再改数字
+static_assert(sizeof(Snowflake) == 44 && offsetof(Snowflake, landTick) == 32,
+              "Snowflake layout changed, bump SNOW_STATE_VERSION");
+static_assert(sizeof(CompactFlake) == 16,
+              "CompactFlake layout changed, bump SNOW_STATE_VERSION");
+static const uint32_t STATE_FLAG_COMPACT = 1;
+
+// 头后面数据的校验和
+uint32_t StateChecksum(const void *data, size_t size);
+
+#ifdef _WIN32
+typedef wchar_t PathChar;
+#else
+typedef char PathChar;
+#endif
+
+// 只读映射整个文件 (启动时一次读进来)
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const PathChar *path);
+    void Close();
+
+    const void *Data() const { return m_pData; }
+    size_t      Size() const { return m_size; }
+
+  private:
+    const void *m_pData = nullptr;
+    size_t      m_size  = 0;
+
+#ifdef _WIN32
+    void *m_hFile    = nullptr;  // HANDLE
+    void *m_hMapping = nullptr;
+#endif
+};
+
+// 整个写出去：先写临时文件再改名，写到一半断电也不会留下半个存档
+bool WriteWholeFile(const PathChar *path, const void *data, size_t size);
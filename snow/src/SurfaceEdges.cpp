@@ -0,0 +1,84 @@
+#include "SurfaceEdges.h"
+
+// 把每个可积雪障碍物的顶边切成“露在外面”的几段
+// 以前每颗雪花着陆时都要回头扫一遍更高层的窗口 (Raycast)，
+// 现在障碍物变了才算一次，遮挡的部分直接不进表
+void SurfaceEdges::Build(const std::vector<Obstacle> &obstacles)
+{
+    m_edges.clear();
+
+    std::vector<SurfaceEdge> pieces;
+    for (size_t i = 0; i < obstacles.size(); ++i)
+    {
+        const auto &obs = obstacles[i];
+
+        // 不可积雪的表面 (比如最大化窗口) 不进表，雪花直接穿过去
+        // 但它还是会挡住它下面的窗口
+        if (!obs.canAccumulate)
+            continue;
+
+        float top = (float)obs.rect.top;
+        pieces.clear();
+        if (obs.topMask.empty())
+        {
+            pieces.push_back(
+                {top, (float)obs.rect.left, (float)obs.rect.right, obs.id});
+        }
+        else
+        {
+            // 形状不是矩形的：只有掩码里连续实心的几段才是顶边
+            int width = obs.rect.right - obs.rect.left;
+            for (int from = SurfaceMask::Next(obs.topMask, width, 0, true);
+                 from < width;)
+            {
+                int to = SurfaceMask::Next(obs.topMask, width, from, false);
+                pieces.push_back({top,
+                                  (float)(obs.rect.left + from),
+                                  (float)(obs.rect.left + to),
+                                  obs.id});
+                from = SurfaceMask::Next(obs.topMask, width, to, true);
+            }
+        }
+
+        // 被更高层 (Z-Order 在前面) 的窗口盖住的部分切掉
+        for (size_t j = 0; j < i && !pieces.empty(); ++j)
+        {
+            const auto &higher = obstacles[j].rect;
+            if (top < higher.top || top > higher.bottom)
+                continue;
+
+            float cutL = (float)higher.left;
+            float cutR = (float)higher.right;
+
+            size_t n = pieces.size();
+            for (size_t k = 0; k < n; ++k)
+            {
+                SurfaceEdge p = pieces[k];
+                if (p.right < cutL || p.left > cutR)
+                    continue;  // 不相交
+
+                // 剩下左边一截 (可能没有) 和右边一截 (可能没有)
+                pieces[k].right = p.left < cutL ? cutL : p.left - 1.0f;
+                if (p.right > cutR)
+                    pieces.push_back({top, cutR, p.right, p.id});
+            }
+
+            // 整段被盖住的去掉
+            pieces.erase(std::remove_if(pieces.begin(),
+                                        pieces.end(),
+                                        [](const SurfaceEdge &e) {
+                                            return e.right < e.left;
+                                        }),
+                         pieces.end());
+        }
+
+        m_edges.insert(m_edges.end(), pieces.begin(), pieces.end());
+    }
+
+    // 从上到下排好，同一高度的从左到右
+    std::sort(m_edges.begin(),
+              m_edges.end(),
+              [](const SurfaceEdge &a, const SurfaceEdge &b) {
+                  return a.top != b.top ? a.top < b.top : a.left < b.left;
+              });
+}
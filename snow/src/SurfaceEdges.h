@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "WindowSource.h"
+#include "SurfaceMask.h"
+
+// 一段可以积雪的表面：某个障碍物的顶边上，没被更高层窗口盖住的那一截
+struct SurfaceEdge
+{
+    float top;
+    float left;
+    float right;
+
+    WindowId id;  // 是哪个障碍物的顶边
+};
+
+// 所有露在外面的顶边，按高度从上到下排好
+// 障碍物变了才重建一次；每颗雪花查询时二分到自己附近，只看那几条
+class SurfaceEdges
+{
+  public:
+    // 着陆的宽容度：上一帧已经越过顶边不超过这么多像素的，也算落在上面
+    static constexpr float LANDING_SLACK = 5.0f;
+
+    void Build(const std::vector<Obstacle> &obstacles);
+
+    bool Empty() const { return m_edges.empty(); }
+
+    const std::vector<SurfaceEdge> &Edges() const { return m_edges; }
+
+    // 落在 (x, y) 的雪是堆在哪一条表面上的 (Edges() 的下标)，不在表面上返回 -1
+    // 着陆时 y 就是表面的高度；紧凑存储的坐标是定点数，差一点点也算
+    int Find(float x, float y) const
+    {
+        for (auto it = LowerBound(y - 0.5f);
+             it != m_edges.end() && it->top <= y + 0.5f;
+             ++it)
+        {
+            if (x >= it->left && x <= it->right)
+                return (int)(it - m_edges.begin());
+        }
+        return -1;
+    }
+
+    // y 下面 (含 y) 最近的一条表面的高度，没有就返回 false
+    bool NextTop(float y, float &top) const
+    {
+        auto it = LowerBound(y);
+        if (it == m_edges.end())
+            return false;
+        top = it->top;
+        return true;
+    }
+
+    // 扫掠测试：这一帧从 (x0, y0) 走到 (x1, y1)，最先穿过的是哪条表面
+    // 穿过了就返回 true，并给出交点
+    // 只看往下走的：往上飘的雪花不会落到表面上
+    inline bool Sweep(float  x0,
+                      float  y0,
+                      float  x1,
+                      float  y1,
+                      float &hitX,
+                      float &hitY) const
+    {
+        if (y1 <= y0)
+            return false;
+
+        float invDy = 1.0f / (y1 - y0);
+        for (auto it = LowerBound(y0 - LANDING_SLACK);
+             it != m_edges.end() && it->top <= y1;
+             ++it)
+        {
+            // 线段在这条表面高度上的横坐标
+            float t = (it->top - y0) * invDy;
+            t       = t < 0.0f ? 0.0f : t;
+            float x = x0 + (x1 - x0) * t;
+
+            if (x >= it->left && x <= it->right)
+            {
+                hitX = x;
+                hitY = it->top;
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    std::vector<SurfaceEdge>::const_iterator LowerBound(float y) const
+    {
+        return std::lower_bound(
+            m_edges.begin(),
+            m_edges.end(),
+            y,
+            [](const SurfaceEdge &e, float v) { return e.top < v; });
+    }
+
+    std::vector<SurfaceEdge> m_edges;
+};
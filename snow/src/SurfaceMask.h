@@ -0,0 +1,113 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 一条顶边的逐列掩码 (打包成 64 位一组的位图)：
+// 第 i 位 = 从 rect.left 往右数第 i 列上能不能积雪
+// 只有形状和矩形不一样的窗口 (Win11 的圆角、SetWindowRgn 的异形窗口) 才有，
+// 空的就是整条边都能积雪 (绝大多数窗口，一点额外开销都没有)
+// 建表面 (SurfaceEdges::Build) 时按掩码把顶边切成几段实心的，
+// 之后的碰撞检测还是只比矩形，不用逐颗查位图
+class SurfaceMask
+{
+  public:
+    static size_t Words(int width) { return (size_t)(width + 63) / 64; }
+
+    // 整条都设成 solid (能积雪) 或者都不能
+    static void Reset(std::vector<uint64_t> &bits, int width, bool solid)
+    {
+        bits.assign(Words(width), solid ? ~0ull : 0ull);
+        if (solid && (width & 63))
+            bits.back() = (1ull << (width & 63)) - 1;
+    }
+
+    // [from, to) 这几列设成能积雪 (超出范围的部分自动裁掉)
+    static void SetRange(std::vector<uint64_t> &bits,
+                         int                    width,
+                         int                    from,
+                         int                    to)
+    {
+        from = from < 0 ? 0 : from;
+        to   = to > width ? width : to;
+        while (from < to)
+        {
+            int      bit   = from & 63;
+            int      n     = to - from < 64 - bit ? to - from : 64 - bit;
+            uint64_t range = n == 64 ? ~0ull : ((1ull << n) - 1) << bit;
+            bits[from >> 6] |= range;
+            from += n;
+        }
+    }
+
+    // 是不是整条都能积雪 (那就不用掩码了)
+    static bool AllSolid(const std::vector<uint64_t> &bits, int width)
+    {
+        return Next(bits, width, 0, false) == width;
+    }
+
+    // 从 from 开始往右找第一个值为 value 的列，没有就返回 width
+    // 一次看 64 列
+    static int Next(const std::vector<uint64_t> &bits,
+                    int                          width,
+                    int                          from,
+                    bool                         value)
+    {
+        while (from < width)
+        {
+            size_t   w    = (size_t)from >> 6;
+            uint64_t word = value ? bits[w] : ~bits[w];
+            word &= ~0ull << (from & 63);
+            if (word)
+            {
+                int i = (int)(w * 64) + CountTrailingZeros(word);
+                return i < width ? i : width;
+            }
+            from = (int)((w + 1) * 64);
+        }
+        return width;
+    }
+
+    // Win11 的圆角：两头的曲线离顶边超过 1 像素的列不算顶边
+    // (雪落到那里会擦着圆角掉下去)
+    static void RoundedCorners(std::vector<uint64_t> &bits,
+                               int                    width,
+                               int                    radius)
+    {
+        Reset(bits, width, true);
+
+        int      edge = 0;  // 两头各有几列不算
+        uint64_t r2   = (uint64_t)radius * radius;
+        for (int c = 0; c < radius && c * 2 < width; ++c)
+        {
+            float dx    = (float)radius - (c + 0.5f);
+            float depth = (float)radius - std::sqrt((float)r2 - dx * dx);
+            if (depth <= 1.0f)
+                break;
+            edge = c + 1;
+        }
+
+        for (int c = 0; c < edge; ++c)
+        {
+            bits[(size_t)c >> 6] &= ~(1ull << (c & 63));
+            int m = width - 1 - c;
+            bits[(size_t)m >> 6] &= ~(1ull << (m & 63));
+        }
+    }
+
+  private:
+    static int CountTrailingZeros(uint64_t word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return (int)index;
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+};
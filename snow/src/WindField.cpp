@@ -0,0 +1,114 @@
+#include "WindField.h"
+#include <vector>
+
+// 生成纹理：先叠几层可平铺的值噪声当作“流函数”，再求旋度
+// 旋度场天然无散度，雪花会被卷成涡旋而不是挤成一团
+void WindField::Initialize(uint32_t seed)
+{
+    m_gen.seed(seed);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+
+    // 1. 流函数 psi：周期分别为 4 / 8 / 16 个格点的三层噪声
+    std::vector<float> psi(GRID_SIZE * GRID_SIZE, 0.0f);
+    float              amplitude = 1.0f;
+
+    for (int period = 4; period <= 16; period *= 2)
+    {
+        std::vector<float> lattice(period * period);
+        for (auto &v : lattice)
+            v = dis(m_gen);
+
+        int step = GRID_SIZE / period;
+        for (int y = 0; y < GRID_SIZE; ++y)
+        {
+            int   gy0 = y / step;
+            int   gy1 = (gy0 + 1) % period;  // 回绕，保证可平铺
+            float ty  = (float)(y % step) / step;
+            ty        = ty * ty * (3.0f - 2.0f * ty);  // smoothstep
+
+            for (int x = 0; x < GRID_SIZE; ++x)
+            {
+                int   gx0 = x / step;
+                int   gx1 = (gx0 + 1) % period;
+                float tx  = (float)(x % step) / step;
+                tx        = tx * tx * (3.0f - 2.0f * tx);
+
+                float a = lattice[gy0 * period + gx0];
+                float b = lattice[gy0 * period + gx1];
+                float c = lattice[gy1 * period + gx0];
+                float d = lattice[gy1 * period + gx1];
+
+                float top = a + (b - a) * tx;
+                float bot = c + (d - c) * tx;
+                psi[y * GRID_SIZE + x] += amplitude * (top + (bot - top) * ty);
+            }
+        }
+
+        amplitude *= 0.5f;
+    }
+
+    // 2. 旋度：v = (d(psi)/dy, -d(psi)/dx)，用中心差分，边界同样回绕
+    float maxLen = 0.0f;
+    for (int y = 0; y < GRID_SIZE; ++y)
+    {
+        int up   = (y + GRID_SIZE - 1) & GRID_MASK;
+        int down = (y + 1) & GRID_MASK;
+
+        for (int x = 0; x < GRID_SIZE; ++x)
+        {
+            int left  = (x + GRID_SIZE - 1) & GRID_MASK;
+            int right = (x + 1) & GRID_MASK;
+
+            float dPsiDx =
+                (psi[y * GRID_SIZE + right] - psi[y * GRID_SIZE + left]) * 0.5f;
+            float dPsiDy =
+                (psi[down * GRID_SIZE + x] - psi[up * GRID_SIZE + x]) * 0.5f;
+
+            Cell &c = m_grid[y * GRID_SIZE + x];
+            c.x     = dPsiDy;
+            c.y     = -dPsiDx;
+
+            float len = sqrtf(c.x * c.x + c.y * c.y);
+            if (len > maxLen)
+                maxLen = len;
+        }
+    }
+
+    // 3. 归一化：最强的地方正好是 1.0，方便用 m_turbulence 控制幅度
+    if (maxLen > 0.0f)
+    {
+        for (auto &c : m_grid)
+        {
+            c.x /= maxLen;
+            c.y /= maxLen;
+        }
+    }
+
+    m_offsetX = 0.0f;
+    m_offsetY = 0.0f;
+    m_gust    = 1.0f;
+}
+
+// 每帧只改几个标量，纹理本身永远不重算
+void WindField::Advance(float baseWind)
+{
+    // 纹理整体随风平移 (风越大，涡流被吹走得越快)，
+    // 再加一点缓慢的上升漂移，让同一个位置的风也会随时间变化
+    m_offsetX -= 0.004f * baseWind;
+    m_offsetY += 0.002f;
+
+    // 平移量一直在累加，按纹理周期回绕，防止 float 精度越跑越差
+    if (m_offsetX > GRID_SIZE || m_offsetX < -GRID_SIZE)
+        m_offsetX = fmodf(m_offsetX, (float)GRID_SIZE);
+    if (m_offsetY > GRID_SIZE)
+        m_offsetY -= GRID_SIZE;
+
+    // 阵风：围绕 1.0 的均值回归随机游走 (每帧只抽一个随机数)
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    m_gust += (1.0f - m_gust) * 0.01f + dis(m_gen) * 0.03f;
+
+    if (m_gust < GUST_MIN)
+        m_gust = GUST_MIN;
+    if (m_gust > GUST_MAX)
+        m_gust = GUST_MAX;
+}
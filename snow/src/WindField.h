@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <random>
+
+// 风场：一张预先算好的、可平铺的旋度噪声 (curl noise) 纹理
+// 每颗雪花只做一次双线性查表，不用逐颗计算噪声
+class WindField
+{
+  public:
+    // 64x64 个格子，每格两个 float，一共 32KB，刚好能待在缓存里
+    static const int GRID_SIZE = 64;
+    static const int GRID_MASK = GRID_SIZE - 1;
+
+    // 初始化：用给定的种子生成噪声纹理
+    void Initialize(uint32_t seed);
+
+    // 每帧推进一次：纹理随风平移，阵风强度缓慢随机游走
+    void Advance(float baseWind);
+
+    // 当前阵风倍率 (0.3 ~ 1.8，平均 1.0)
+    float Gust() const { return m_gust; }
+
+    // Sample 结果每个分量的绝对值上限 (纹理已归一化，再乘最强的阵风)
+    float MaxSample() const { return m_turbulence * GUST_MAX; }
+
+    // 湍流强度 (像素/帧)，0 表示关闭
+    void  SetTurbulence(float strength) { m_turbulence = strength; }
+    float Turbulence() const { return m_turbulence; }
+
+    // 采样：屏幕坐标 -> 湍流速度 (已乘上强度和阵风)
+    // 放在头文件里，方便编译器内联进 Update 的循环
+    inline void Sample(float x, float y, float &outX, float &outY) const
+    {
+        // 屏幕坐标换算到格子坐标，再加上平移量
+        // 额外加一个纹理周期的整数倍，保证结果是正数：
+        // 这样 (int) 截断就等于 floor，不用调 floorf，循环也能向量化
+        float fx = x * m_invCellSize + m_offsetX + SAMPLE_BIAS;
+        float fy = y * m_invCellSize + m_offsetY + SAMPLE_BIAS;
+
+        int   ix = (int)fx;
+        int   iy = (int)fy;
+        float tx = fx - (float)ix;
+        float ty = fy - (float)iy;
+
+        // 纹理可平铺，直接用掩码回绕
+        int x0 = ix & GRID_MASK;
+        int y0 = iy & GRID_MASK;
+        int x1 = (x0 + 1) & GRID_MASK;
+        int y1 = (y0 + 1) & GRID_MASK;
+
+        const Cell &c00 = m_grid[y0 * GRID_SIZE + x0];
+        const Cell &c10 = m_grid[y0 * GRID_SIZE + x1];
+        const Cell &c01 = m_grid[y1 * GRID_SIZE + x0];
+        const Cell &c11 = m_grid[y1 * GRID_SIZE + x1];
+
+        float topX = c00.x + (c10.x - c00.x) * tx;
+        float topY = c00.y + (c10.y - c00.y) * tx;
+        float botX = c01.x + (c11.x - c01.x) * tx;
+        float botY = c01.y + (c11.y - c01.y) * tx;
+
+        float scale = m_turbulence * m_gust;
+        outX        = (topX + (botX - topX) * ty) * scale;
+        outY        = (topY + (botY - topY) * ty) * scale;
+    }
+
+  private:
+    static constexpr float GUST_MIN = 0.3f;
+    static constexpr float GUST_MAX = 1.8f;
+
+    // 采样偏移 (64 的整数倍，精度仍有 1/2048 格)
+    static constexpr float SAMPLE_BIAS = 4096.0f;
+
+    // 一个格子里的速度 (x/y 挨在一起，一次查表只碰两条缓存行)
+    struct Cell
+    {
+        float x;
+        float y;
+    };
+
+    Cell m_grid[GRID_SIZE * GRID_SIZE] = {};
+
+    // 每个格子覆盖 96 像素，整张纹理约 6000 像素宽
+    float m_invCellSize = 1.0f / 96.0f;
+
+    // 纹理的平移量 (单位：格子)
+    float m_offsetX = 0.0f;
+    float m_offsetY = 0.0f;
+
+    float m_gust       = 1.0f;
+    float m_turbulence = 0.4f;
+
+    std::mt19937 m_gen;
+};
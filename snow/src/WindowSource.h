@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+// 非 Windows (比如在 Linux 上跑基准测试) 时，自己定义用到的类型
+typedef long LONG;
+struct RECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+struct POINT
+{
+    LONG x;
+    LONG y;
+};
+#endif
+
+// 顶层窗口的来源：真正的桌面 (EnumWindows) 或者合成出来的假桌面
+// 障碍物的查找逻辑 (ObstacleFinder) 只通过这个接口问窗口的情况，
+// 所以不开 Windows 也能测它
+typedef uintptr_t WindowId;
+
+// 任务栏的 id (不和任何窗口撞)
+static const WindowId TASKBAR_ID = ~(WindowId)0;
+
+// --- 修改 1：升级结构体，加入标记 ---
+struct Obstacle
+{
+    RECT rect;
+    bool canAccumulate;  // true=正常积雪, false=我是墙但不积雪(如最大化窗口)
+
+    // 是哪个窗口 (HWND)：两次刷新之间认出同一个窗口，
+    // 窗口挪了，堆在上面的雪跟着挪
+    WindowId id;
+
+    // 顶边上哪几列真的能积雪 (格式见 SurfaceMask.h)，空 = 整条都能
+    std::vector<uint64_t> topMask;
+};
+
+// 枚举回调：返回 false 就停止枚举 (和 EnumWindowsProc 一样)
+typedef bool (*WindowVisitor)(WindowId window, void *ctx);
+
+class WindowSource
+{
+  public:
+    virtual ~WindowSource() {}
+
+    // 任务栏的矩形，没有 (或者隐藏了) 就返回 false
+    virtual bool GetTaskbar(RECT &rc) = 0;
+
+    // 按 Z 顺序从上到下把每个顶层窗口交给 visit
+    virtual void Enumerate(WindowVisitor visit, void *ctx) = 0;
+
+    // 下面这些在枚举回调里按需调用 (在真正的桌面上每一个都是一次系统调用)
+    virtual bool IsVisible(WindowId window) = 0;
+    virtual bool IsMinimized(WindowId window) = 0;
+    virtual void GetClass(WindowId window, wchar_t *name, int size) = 0;
+    virtual void GetFrame(WindowId window, RECT &rc) = 0;
+
+    // 窗口矩形 (含阴影)：不用问 DWM，很便宜
+    // 缓存拿它判断窗口动没动，没动就不用再 GetFrame
+    virtual void GetBounds(WindowId window, RECT &rc) = 0;
+
+    // 形状和边框矩形不一样的窗口 (圆角、异形)：给出顶边的逐列掩码
+    // (frame 是 GetFrame 的结果，第 0 位对应 frame.left)
+    // 就是个矩形的返回 false
+    virtual bool GetTopMask(WindowId               window,
+                            const RECT            &frame,
+                            std::vector<uint64_t> &bits) = 0;
+};
@@ -2,110 +2,244 @@
 #include <windows.h>
 #include <vector>
 #include <dwmapi.h>
+#include <shellscalingapi.h>
+#include "WindowSource.h"
+#include "ObstacleFinder.h"
+#include "SurfaceMask.h"
 
 #pragma comment(lib, "dwmapi.lib")
+#pragma comment(lib, "shcore.lib")
 
-// --- ޸ 1ṹ壬 ---
-struct Obstacle
-{
-    RECT rect;
-    bool canAccumulate;  // true=ѩ, false=ǽѩ(󻯴)
-};
-
-struct SearchContext
-{
-    std::vector<Obstacle> *pResult;
-    std::vector<RECT>      blockers;
-};
-
-class WindowUtils
+// 真正的桌面：EnumWindows + GetClassName + DwmGetWindowAttribute
+class Win32WindowSource : public WindowSource
 {
   public:
-    static std::vector<Obstacle> GetObstacles(HWND myHwnd)
+    bool GetTaskbar(RECT &rc) override
     {
-        std::vector<Obstacle> obstacles;
-        std::vector<RECT>     blockers;
-
-        // 1. ȡ
         HWND hTaskBar = FindWindow(L"Shell_TrayWnd", NULL);
-        if (hTaskBar && IsWindowVisible(hTaskBar))
-        {
-            RECT rc;
-            GetWindowRect(hTaskBar, &rc);
-            // ϰ(ɻѩ)Ҳڵ
-            obstacles.push_back({rc, true});
-            blockers.push_back(rc);
-        }
-
-        // 2. 
-        SearchContext ctx;
-        ctx.pResult  = &obstacles;
-        ctx.blockers = blockers;
-
-        EnumWindows(EnumWindowsProc, (LPARAM)&ctx);
-
-        return obstacles;
+        if (!hTaskBar || !IsWindowVisible(hTaskBar))
+            return false;
+        GetWindowRect(hTaskBar, &rc);
+        return true;
     }
 
-  private:
-    static bool IsFullyCovered(const RECT &target, const RECT &blocker)
+    void Enumerate(WindowVisitor visit, void *ctx) override
     {
-        // ݲ
-        const long TOLERANCE = 20;
-        return target.left >= (blocker.left - TOLERANCE) &&
-               target.right <= (blocker.right + TOLERANCE) &&
-               target.top >= (blocker.top - TOLERANCE) &&
-               target.bottom <= (blocker.bottom + TOLERANCE);
+        EnumContext enumCtx = {visit, ctx};
+        EnumWindows(EnumWindowsProc, (LPARAM)&enumCtx);
     }
 
-    static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam)
+    bool IsVisible(WindowId window) override
     {
-        auto *pCtx = (SearchContext *)lParam;
+        return IsWindowVisible((HWND)window) != FALSE;
+    }
 
-        if (!IsWindowVisible(hwnd))
-            return TRUE;
-        if (IsIconic(hwnd))
-            return TRUE;
+    bool IsMinimized(WindowId window) override
+    {
+        return IsIconic((HWND)window) != FALSE;
+    }
 
-        WCHAR className[256];
-        GetClassName(hwnd, className, 256);
-        if (wcscmp(className, L"SnowWindowClass") == 0)
-            return TRUE;
-        if (wcscmp(className, L"Progman") == 0)
-            return TRUE;
-        if (wcscmp(className, L"WorkerW") == 0)
-            return TRUE;
+    void GetClass(WindowId window, wchar_t *name, int size) override
+    {
+        name[0] = L'\0';
+        GetClassName((HWND)window, name, size);
+    }
 
-        RECT    rcFrame;
+    void GetFrame(WindowId window, RECT &rc) override
+    {
+        // 优先用 DWM 的真实边框 (不含阴影)，拿不到再退回 GetWindowRect
         HRESULT hr = DwmGetWindowAttribute(
-            hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &rcFrame, sizeof(rcFrame));
+            (HWND)window, DWMWA_EXTENDED_FRAME_BOUNDS, &rc, sizeof(rc));
         if (FAILED(hr))
-            GetWindowRect(hwnd, &rcFrame);
+            GetWindowRect((HWND)window, &rc);
+    }
 
-        // [Step 1] ڵ
-        for (const auto &blocker : pCtx->blockers)
-        {
-            if (IsFullyCovered(rcFrame, blocker))
-                return TRUE;  // ȫס޳
-        }
+    void GetBounds(WindowId window, RECT &rc) override
+    {
+        GetWindowRect((HWND)window, &rc);
+    }
+
+    bool GetTopMask(WindowId               window,
+                    const RECT            &frame,
+                    std::vector<uint64_t> &bits) override
+    {
+        HWND hwnd  = (HWND)window;
+        int  width = frame.right - frame.left;
+
+        // 1. SetWindowRgn 设过形状的：区域最上面那条带子覆盖的列才算顶边
+        if (GetRegionTopMask(hwnd, frame, width, bits))
+            return true;
+
+        // 2. Win11 的圆角 (最大化的不圆；窗口自己说了不要圆角的也不圆)
+        if (!IsRoundedCornerOS() || IsZoomed(hwnd))
+            return false;
+
+        DWM_WINDOW_CORNER_PREFERENCE pref = DWMWCP_DEFAULT;
+        DwmGetWindowAttribute(
+            hwnd, DWMWA_WINDOW_CORNER_PREFERENCE, &pref, sizeof(pref));
+        if (pref == DWMWCP_DONOTROUND)
+            return false;
+
+        int radius = pref == DWMWCP_ROUNDSMALL ? 4 : 8;
+        radius     = MulDiv(radius, (int)GetDpiForWindow(hwnd), 96);
+        SurfaceMask::RoundedCorners(bits, width, radius);
+        return true;
+    }
 
-        // [Step 2] עΪڵ (ǽ)
-        pCtx->blockers.push_back(rcFrame);
+  private:
+    struct EnumContext
+    {
+        WindowVisitor visit;
+        void         *ctx;
+    };
 
-        // [Step 3] ѩж
-        bool isSlippery = (rcFrame.top < 10);  // ()ǹ⻬
+    static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam)
+    {
+        auto *pEnum = (EnumContext *)lParam;
+        return pEnum->visit((WindowId)hwnd, pEnum->ctx) ? TRUE : FALSE;
+    }
 
-        if (isSlippery)
+    static bool GetRegionTopMask(HWND                   hwnd,
+                                 const RECT            &frame,
+                                 int                    width,
+                                 std::vector<uint64_t> &bits)
+    {
+        HRGN hRgn = CreateRectRgn(0, 0, 0, 0);
+        int  type = GetWindowRgn(hwnd, hRgn);
+        bool ok   = false;
+
+        DWORD size = (type == SIMPLEREGION || type == COMPLEXREGION)
+                         ? GetRegionData(hRgn, 0, nullptr)
+                         : 0;
+        if (size > 0)
         {
-            // Ȼǽܻѩ
-            pCtx->pResult->push_back({rcFrame, false});
+            std::vector<uint8_t> data(size);
+            RGNDATA             *pData = (RGNDATA *)data.data();
+            if (GetRegionData(hRgn, size, pData))
+            {
+                // 区域的坐标相对于窗口矩形的左上角
+                RECT rcWindow;
+                GetWindowRect(hwnd, &rcWindow);
+                LONG offsetX = rcWindow.left - frame.left;
+
+                const RECT *rects = (const RECT *)pData->Buffer;
+                DWORD       n     = pData->rdh.nCount;
+                LONG        top   = LONG_MAX;
+                for (DWORD i = 0; i < n; ++i)
+                    top = rects[i].top < top ? rects[i].top : top;
+
+                // 阶梯状的圆角区域，最上面几行的带子很窄，放宽 1 像素
+                SurfaceMask::Reset(bits, width, false);
+                for (DWORD i = 0; i < n; ++i)
+                {
+                    if (rects[i].top <= top + 1)
+                        SurfaceMask::SetRange(bits,
+                                              width,
+                                              rects[i].left + offsetX,
+                                              rects[i].right + offsetX);
+                }
+                ok = true;
+            }
         }
-        else
+
+        DeleteObject(hRgn);
+        return ok;
+    }
+
+    // Win11 (build 22000 起) 才有圆角
+    // GetVersionEx 会被兼容性清单骗，直接问 ntdll
+    static bool IsRoundedCornerOS()
+    {
+        static int cached = -1;
+        if (cached < 0)
         {
-            // ڣԻѩ
-            pCtx->pResult->push_back({rcFrame, true});
+            typedef LONG(WINAPI * RtlGetVersionFn)(OSVERSIONINFOW *);
+            auto fn = (RtlGetVersionFn)GetProcAddress(
+                GetModuleHandleW(L"ntdll.dll"), "RtlGetVersion");
+
+            OSVERSIONINFOW info      = {};
+            info.dwOSVersionInfoSize = sizeof(info);
+            cached = fn && fn(&info) == 0 && info.dwBuildNumber >= 22000;
         }
+        return cached != 0;
+    }
+};
+
+class WindowUtils
+{
+  public:
+    // 只在 UI 线程调用 (查找器里的窗口缓存不加锁)
+    static std::vector<Obstacle> GetObstacles(HWND myHwnd)
+    {
+        static ObstacleFinder finder;  // 两次查找之间留着每个窗口的缓存
+
+        Win32WindowSource source;
+        return finder.FindCached(source);
+    }
 
+    // 各个显示器的矩形，换算到覆盖窗口的坐标 (窗口左上角是虚拟屏幕原点)
+    static std::vector<RECT> GetMonitorRects()
+    {
+        std::vector<RECT> monitors;
+        EnumDisplayMonitors(NULL, NULL, EnumMonitorsProc, (LPARAM)&monitors);
+
+        int originX = GetSystemMetrics(SM_XVIRTUALSCREEN);
+        int originY = GetSystemMetrics(SM_YVIRTUALSCREEN);
+        for (auto &rc : monitors)
+            OffsetRect(&rc, -originX, -originY);
+
+        return monitors;
+    }
+
+    // 主显示器的刷新率 (拿不到就按 60)
+    static double GetRefreshRate()
+    {
+        HDC hdc = GetDC(NULL);
+        int hz  = GetDeviceCaps(hdc, VREFRESH);
+        ReleaseDC(NULL, hdc);
+        return hz > 1 ? (double)hz : 60.0;
+    }
+
+    // 自动选渲染的缩小倍数：按 DPI 最低的那块显示器来
+    // (整个虚拟屏幕只有一个渲染目标，不能每块屏各用各的，
+    // 按最低的选，普通屏幕上的雪不会被拉糊)
+    // 150% 以上缩一半，300% 以上缩到 1/3
+    static int GetAutoRenderScale()
+    {
+        UINT minDpi = 0;
+        EnumDisplayMonitors(NULL, NULL, EnumMonitorDpiProc, (LPARAM)&minDpi);
+
+        if (minDpi >= 288)
+            return 3;
+        if (minDpi >= 144)
+            return 2;
+        return 1;
+    }
+
+  private:
+    static BOOL CALLBACK EnumMonitorDpiProc(HMONITOR hMonitor,
+                                            HDC      hdc,
+                                            LPRECT   lprcMonitor,
+                                            LPARAM   lParam)
+    {
+        UINT *pMinDpi = (UINT *)lParam;
+        UINT  dpiX    = 96;
+        UINT  dpiY    = 96;
+        if (FAILED(GetDpiForMonitor(hMonitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY)))
+            dpiX = 96;
+
+        if (*pMinDpi == 0 || dpiX < *pMinDpi)
+            *pMinDpi = dpiX;
+        return TRUE;
+    }
+
+    static BOOL CALLBACK EnumMonitorsProc(HMONITOR hMonitor,
+                                          HDC      hdc,
+                                          LPRECT   lprcMonitor,
+                                          LPARAM   lParam)
+    {
+        auto *pMonitors = (std::vector<RECT> *)lParam;
+        pMonitors->push_back(*lprcMonitor);
         return TRUE;
     }
 };
\ No newline at end of file